@@ -9,6 +9,7 @@ int main(int argc, char ** argv) {
 		return 1;
 	}
 	SDL_Log("Initialized SDL subsystems");
+	chess_init();
 	Display display;
 	if (!display_open(&display)) {
 		SDL_Log("%s", SDL_GetError());
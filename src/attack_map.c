@@ -0,0 +1,137 @@
+#include "include/attack_map.h"
+
+#if defined(CHESS_ATTACK_MAP_SSE2) && defined(__SSE2__)
+#define ATTACK_MAP_SSE2
+#endif
+
+#if defined(CHESS_X86_KERNELS) || defined(ATTACK_MAP_SSE2)
+#include <immintrin.h>
+#endif
+
+/* pawns, knights and king, the same in every build */
+static BitBoard leaper_attack_map(const ChessBoard * board, ChessSide side) {
+	const BitBoard * pieces = board->bitboards.pieces;
+	const BitBoard own = board->bitboards.sides[side];
+	BitBoard pawns = pieces[CHESS_PAWN] & own;
+	BitBoard knights = pieces[CHESS_KNIGHT] & own;
+	BitBoard king = pieces[CHESS_KING] & own;
+	BitBoard attacks = side == WHITE_SIDE
+		? shift_step(pawns, 9, NOT_H_FILE) | shift_step(pawns, 7, NOT_A_FILE)
+		: shift_step(pawns, -7, NOT_H_FILE) | shift_step(pawns, -9, NOT_A_FILE);
+	attacks |= shift_step(knights, 17, NOT_H_FILE) | shift_step(knights, 15, NOT_A_FILE)
+		| shift_step(knights, 10, NOT_GH_FILES) | shift_step(knights, 6, NOT_AB_FILES)
+		| shift_step(knights, -15, NOT_H_FILE) | shift_step(knights, -17, NOT_A_FILE)
+		| shift_step(knights, -6, NOT_GH_FILES) | shift_step(knights, -10, NOT_AB_FILES);
+	attacks |= shift_step(king, 8, ~(BitBoard)0) | shift_step(king, -8, ~(BitBoard)0)
+		| shift_step(king, 1, NOT_H_FILE) | shift_step(king, -1, NOT_A_FILE)
+		| shift_step(king, 9, NOT_H_FILE) | shift_step(king, 7, NOT_A_FILE)
+		| shift_step(king, -7, NOT_H_FILE) | shift_step(king, -9, NOT_A_FILE);
+	return attacks;
+}
+
+static BitBoard slider_attack_map_scalar(BitBoard straight, BitBoard diagonal, BitBoard empty) {
+	return slider_fill(straight, empty, 8, ~(BitBoard)0) | slider_fill(straight, empty, -8, ~(BitBoard)0)
+		| slider_fill(straight, empty, 1, NOT_H_FILE) | slider_fill(straight, empty, -1, NOT_A_FILE)
+		| slider_fill(diagonal, empty, 9, NOT_H_FILE) | slider_fill(diagonal, empty, 7, NOT_A_FILE)
+		| slider_fill(diagonal, empty, -7, NOT_H_FILE) | slider_fill(diagonal, empty, -9, NOT_A_FILE);
+}
+
+#ifdef CHESS_X86_KERNELS
+/* lanes 8, 1, 9 and 7 squares up in one vector, the same amounts down in the other.
+ * Built for AVX2 whatever the compiler flags, it only runs under CHESS_KERNEL_AVX2.
+ */
+__attribute__((target("avx2")))
+static BitBoard slider_attack_map_avx2(BitBoard straight, BitBoard diagonal, BitBoard empty) {
+	const __m256i shift = _mm256_set_epi64x(7, 9, 1, 8);
+	const __m256i up_wrap = _mm256_set_epi64x((i64)NOT_A_FILE, (i64)NOT_H_FILE, (i64)NOT_H_FILE, -1);
+	const __m256i down_wrap = _mm256_set_epi64x((i64)NOT_H_FILE, (i64)NOT_A_FILE, (i64)NOT_A_FILE, -1);
+	const __m256i sliders = _mm256_set_epi64x((i64)diagonal, (i64)diagonal, (i64)straight, (i64)straight);
+	const __m256i shift2 = _mm256_add_epi64(shift, shift);
+	const __m256i shift4 = _mm256_add_epi64(shift2, shift2);
+	__m256i up_empty = _mm256_and_si256(_mm256_set1_epi64x((i64)empty), up_wrap);
+	__m256i down_empty = _mm256_and_si256(_mm256_set1_epi64x((i64)empty), down_wrap);
+	__m256i up = sliders;
+	__m256i down = sliders;
+	up = _mm256_or_si256(up, _mm256_and_si256(up_empty, _mm256_sllv_epi64(up, shift)));
+	down = _mm256_or_si256(down, _mm256_and_si256(down_empty, _mm256_srlv_epi64(down, shift)));
+	up_empty = _mm256_and_si256(up_empty, _mm256_sllv_epi64(up_empty, shift));
+	down_empty = _mm256_and_si256(down_empty, _mm256_srlv_epi64(down_empty, shift));
+	up = _mm256_or_si256(up, _mm256_and_si256(up_empty, _mm256_sllv_epi64(up, shift2)));
+	down = _mm256_or_si256(down, _mm256_and_si256(down_empty, _mm256_srlv_epi64(down, shift2)));
+	up_empty = _mm256_and_si256(up_empty, _mm256_sllv_epi64(up_empty, shift2));
+	down_empty = _mm256_and_si256(down_empty, _mm256_srlv_epi64(down_empty, shift2));
+	up = _mm256_or_si256(up, _mm256_and_si256(up_empty, _mm256_sllv_epi64(up, shift4)));
+	down = _mm256_or_si256(down, _mm256_and_si256(down_empty, _mm256_srlv_epi64(down, shift4)));
+	__m256i attacks = _mm256_or_si256(
+		_mm256_and_si256(_mm256_sllv_epi64(up, shift), up_wrap),
+		_mm256_and_si256(_mm256_srlv_epi64(down, shift), down_wrap));
+	__m128i half = _mm_or_si128(_mm256_castsi256_si128(attacks), _mm256_extracti128_si256(attacks, 1));
+	return (BitBoard)_mm_cvtsi128_si64(_mm_or_si128(half, _mm_unpackhi_epi64(half, half)));
+}
+#endif
+
+#ifdef ATTACK_MAP_SSE2
+/* bit i goes to bit 63 - i, so shifting a reversed board up shifts the board down */
+static BitBoard bitboard_reverse(BitBoard bb) {
+	bb = ((bb >> 1) & 0x5555555555555555) | ((bb & 0x5555555555555555) << 1);
+	bb = ((bb >> 2) & 0x3333333333333333) | ((bb & 0x3333333333333333) << 2);
+	bb = ((bb >> 4) & 0x0F0F0F0F0F0F0F0F) | ((bb & 0x0F0F0F0F0F0F0F0F) << 4);
+	return __builtin_bswap64(bb);
+}
+
+/* SSE2 only shifts both lanes by the same amount, so the low lane goes up the board
+ * and the high lane goes down it on reversed boards. Reversing swaps the a and h files,
+ * so the opposite direction's wrap comes out equal to this one's.
+ */
+static __m128i slider_fill_pair(__m128i sliders, __m128i empty, int shift, BitBoard wrap) {
+	const __m128i count = _mm_cvtsi32_si128(shift);
+	const __m128i count2 = _mm_cvtsi32_si128(2 * shift);
+	const __m128i count4 = _mm_cvtsi32_si128(4 * shift);
+	const __m128i wraps = _mm_set1_epi64x((i64)wrap);
+	empty = _mm_and_si128(empty, wraps);
+	sliders = _mm_or_si128(sliders, _mm_and_si128(empty, _mm_sll_epi64(sliders, count)));
+	empty = _mm_and_si128(empty, _mm_sll_epi64(empty, count));
+	sliders = _mm_or_si128(sliders, _mm_and_si128(empty, _mm_sll_epi64(sliders, count2)));
+	empty = _mm_and_si128(empty, _mm_sll_epi64(empty, count2));
+	sliders = _mm_or_si128(sliders, _mm_and_si128(empty, _mm_sll_epi64(sliders, count4)));
+	return _mm_and_si128(_mm_sll_epi64(sliders, count), wraps);
+}
+
+static BitBoard slider_attack_map_plain(BitBoard straight, BitBoard diagonal, BitBoard empty) {
+	const __m128i empties = _mm_set_epi64x((i64)bitboard_reverse(empty), (i64)empty);
+	const __m128i straights = _mm_set_epi64x((i64)bitboard_reverse(straight), (i64)straight);
+	const __m128i diagonals = _mm_set_epi64x((i64)bitboard_reverse(diagonal), (i64)diagonal);
+	__m128i attacks = _mm_or_si128(
+		_mm_or_si128(slider_fill_pair(straights, empties, 8, ~(BitBoard)0), slider_fill_pair(straights, empties, 1, NOT_H_FILE)),
+		_mm_or_si128(slider_fill_pair(diagonals, empties, 9, NOT_H_FILE), slider_fill_pair(diagonals, empties, 7, NOT_A_FILE)));
+	BitBoard up = (BitBoard)_mm_cvtsi128_si64(attacks);
+	BitBoard down = (BitBoard)_mm_cvtsi128_si64(_mm_unpackhi_epi64(attacks, attacks));
+	return up | bitboard_reverse(down);
+}
+#else
+static BitBoard slider_attack_map_plain(BitBoard straight, BitBoard diagonal, BitBoard empty) {
+	return slider_attack_map_scalar(straight, diagonal, empty);
+}
+#endif
+
+BitBoard board_attack_map_scalar(const ChessBoard * board, ChessSide side) {
+	const BitBoard * pieces = board->bitboards.pieces;
+	const BitBoard own = board->bitboards.sides[side];
+	BitBoard straight = (pieces[CHESS_ROOK] | pieces[CHESS_QUEEN]) & own;
+	BitBoard diagonal = (pieces[CHESS_BISHOP] | pieces[CHESS_QUEEN]) & own;
+	return leaper_attack_map(board, side)
+		| slider_attack_map_scalar(straight, diagonal, ~board->bitboards.occupied);
+}
+
+BitBoard board_attack_map(const ChessBoard * board, ChessSide side) {
+	const BitBoard * pieces = board->bitboards.pieces;
+	const BitBoard own = board->bitboards.sides[side];
+	BitBoard straight = (pieces[CHESS_ROOK] | pieces[CHESS_QUEEN]) & own;
+	BitBoard diagonal = (pieces[CHESS_BISHOP] | pieces[CHESS_QUEEN]) & own;
+	BitBoard empty = ~board->bitboards.occupied;
+#ifdef CHESS_X86_KERNELS
+	if (chess_get_kernel() == CHESS_KERNEL_AVX2)
+		return leaper_attack_map(board, side) | slider_attack_map_avx2(straight, diagonal, empty);
+#endif
+	return leaper_attack_map(board, side) | slider_attack_map_plain(straight, diagonal, empty);
+}
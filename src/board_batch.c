@@ -0,0 +1,381 @@
+#include "include/board_batch.h"
+#include "include/attack_map.h"
+#include <SDL3/SDL_stdinc.h>
+
+#ifdef CHESS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/* Lane helpers are inlined into a plain and an AVX2 build of every kernel, so in the latter
+ * the compiler vectorizes the per lane loops too and not just the explicit slider fills
+ */
+#define LANES_INLINE static inline __attribute__((always_inline))
+
+#define RANK_3 ((BitBoard)0x0000000000FF0000)
+#define RANK_8 ((BitBoard)0xFF00000000000000)
+
+/* lanes castle like white: the king passes f1 for g1, or d1 for c1 with b1 empty too */
+#define KING_SIDE_CASTLE_TARGET ((BitBoard)1 << WHITE_KING_SIDE_CASTLE_IDX)
+#define QUEEN_SIDE_CASTLE_TARGET ((BitBoard)1 << WHITE_QUEEN_SIDE_CASTLE_IDX)
+#define KING_SIDE_CASTLE_PATH ((BitBoard)0x06)
+#define QUEEN_SIDE_CASTLE_PATH ((BitBoard)0x30)
+#define QUEEN_SIDE_CASTLE_EMPTY ((BitBoard)0x70)
+
+typedef struct {
+	int shift;
+	BitBoard wrap;
+	bool diagonal;
+	u8 axis; /* the same for both directions of a line, pinned pieces keep moving along it */
+} Direction;
+
+static const Direction directions[8] = {
+	{ 8, ~(BitBoard)0, false, 0 },
+	{ -8, ~(BitBoard)0, false, 0 },
+	{ 1, NOT_H_FILE, false, 1 },
+	{ -1, NOT_A_FILE, false, 1 },
+	{ 9, NOT_H_FILE, true, 2 },
+	{ -9, NOT_A_FILE, true, 2 },
+	{ 7, NOT_A_FILE, true, 3 },
+	{ -7, NOT_H_FILE, true, 3 },
+};
+
+static const Direction knight_jumps[8] = {
+	{ 17, NOT_H_FILE, false, 0 },
+	{ 15, NOT_A_FILE, false, 0 },
+	{ 10, NOT_GH_FILES, false, 0 },
+	{ 6, NOT_AB_FILES, false, 0 },
+	{ -15, NOT_H_FILE, false, 0 },
+	{ -17, NOT_A_FILE, false, 0 },
+	{ -6, NOT_GH_FILES, false, 0 },
+	{ -10, NOT_AB_FILES, false, 0 },
+};
+
+/* one side's pieces of every lane */
+typedef struct {
+	BitBoard pawns[BOARD_BATCH_SIZE];
+	BitBoard knights[BOARD_BATCH_SIZE];
+	BitBoard diagonal[BOARD_BATCH_SIZE]; /* bishops and queens */
+	BitBoard straight[BOARD_BATCH_SIZE]; /* rooks and queens */
+	BitBoard king[BOARD_BATCH_SIZE];
+} BatchPieces;
+
+static BitBoard relative_bitboard(BitBoard bb, ChessSide side) {
+	return side == WHITE_SIDE ? bb : __builtin_bswap64(bb);
+}
+
+void board_batch_clear(BoardBatch * batch) {
+	SDL_memset(batch, 0, sizeof(*batch));
+}
+
+bool board_batch_push(BoardBatch * batch, const ChessBoard * board) {
+	if (batch->count == BOARD_BATCH_SIZE)
+		return false;
+	usize lane = batch->count++;
+	ChessSide side = board->side;
+	batch->own[lane] = relative_bitboard(board->bitboards.sides[side], side);
+	batch->enemy[lane] = relative_bitboard(board->bitboards.sides[!side], side);
+	for (ChessPiece piece = CHESS_PAWN; piece < CHESS_PIECE_COUNT; ++piece) {
+		batch->pieces[piece][lane] = relative_bitboard(board->bitboards.pieces[piece], side);
+	}
+	/* opt_pawn is the pawn that just double pushed, the capture lands on the square it skipped */
+	batch->en_passant[lane] = board->opt_pawn != INVALID_PIECE_IDX
+		? relative_bitboard((BitBoard)1 << board->opt_pawn, side) << 8
+		: 0;
+	batch->castles[lane] = (board->sides[side].ks_castle_ok ? KING_SIDE_CASTLE_TARGET : 0)
+		| (board->sides[side].qs_castle_ok ? QUEEN_SIDE_CASTLE_TARGET : 0);
+	batch->side[lane] = side;
+	return true;
+}
+
+LANES_INLINE void batch_pieces(const BoardBatch * batch, const BitBoard * sides, BatchPieces * pieces) {
+	for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+		const BitBoard queens = batch->pieces[CHESS_QUEEN][i];
+		pieces->pawns[i] = batch->pieces[CHESS_PAWN][i] & sides[i];
+		pieces->knights[i] = batch->pieces[CHESS_KNIGHT][i] & sides[i];
+		pieces->diagonal[i] = (batch->pieces[CHESS_BISHOP][i] | queens) & sides[i];
+		pieces->straight[i] = (batch->pieces[CHESS_ROOK][i] | queens) & sides[i];
+		pieces->king[i] = batch->pieces[CHESS_KING][i] & sides[i];
+	}
+}
+
+#ifdef CHESS_X86_KERNELS
+__attribute__((target("avx2")))
+static __m256i shift_lanes_avx2(__m256i lanes, __m128i count, bool up) {
+	return up ? _mm256_sll_epi64(lanes, count) : _mm256_srl_epi64(lanes, count);
+}
+
+/* slider_fill four lanes at a time, all lanes shift by the same amount so no variable shifts are needed */
+__attribute__((target("avx2")))
+static void lanes_fill_avx2(BitBoard * out, const BitBoard * sliders, const BitBoard * empty, const Direction * dir) {
+	const bool up = dir->shift > 0;
+	const int amount = up ? dir->shift : -dir->shift;
+	const __m128i count = _mm_cvtsi32_si128(amount);
+	const __m128i count2 = _mm_cvtsi32_si128(2 * amount);
+	const __m128i count4 = _mm_cvtsi32_si128(4 * amount);
+	const __m256i wrap = _mm256_set1_epi64x((i64)dir->wrap);
+	for (usize i = 0; i < BOARD_BATCH_SIZE; i += 4) {
+		__m256i fill = _mm256_loadu_si256((const __m256i *)&sliders[i]);
+		__m256i open = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&empty[i]), wrap);
+		fill = _mm256_or_si256(fill, _mm256_and_si256(open, shift_lanes_avx2(fill, count, up)));
+		open = _mm256_and_si256(open, shift_lanes_avx2(open, count, up));
+		fill = _mm256_or_si256(fill, _mm256_and_si256(open, shift_lanes_avx2(fill, count2, up)));
+		open = _mm256_and_si256(open, shift_lanes_avx2(open, count2, up));
+		fill = _mm256_or_si256(fill, _mm256_and_si256(open, shift_lanes_avx2(fill, count4, up)));
+		_mm256_storeu_si256((__m256i *)&out[i], _mm256_and_si256(shift_lanes_avx2(fill, count, up), wrap));
+	}
+}
+#endif
+
+/* out[i] = slider_fill(sliders[i], empty[i]) toward dir for every lane */
+LANES_INLINE void lanes_fill(BitBoard * out, const BitBoard * sliders, const BitBoard * empty, const Direction * dir, bool avx2) {
+#ifdef CHESS_X86_KERNELS
+	if (avx2) {
+		lanes_fill_avx2(out, sliders, empty, dir);
+		return;
+	}
+#else
+	(void)avx2;
+#endif
+	for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+		out[i] = slider_fill(sliders[i], empty[i], dir->shift, dir->wrap);
+	}
+}
+
+LANES_INLINE BitBoard knight_pattern(BitBoard knights) {
+	BitBoard attacks = 0;
+	for (u8 i = 0; i < 8; ++i) {
+		attacks |= shift_step(knights, knight_jumps[i].shift, knight_jumps[i].wrap);
+	}
+	return attacks;
+}
+
+LANES_INLINE BitBoard king_pattern(BitBoard king) {
+	BitBoard attacks = 0;
+	for (u8 i = 0; i < 8; ++i) {
+		attacks |= shift_step(king, directions[i].shift, directions[i].wrap);
+	}
+	return attacks;
+}
+
+/* up for pawns of the side to move */
+LANES_INLINE BitBoard pawn_pattern(BitBoard pawns, bool up) {
+	return up
+		? shift_step(pawns, 9, NOT_H_FILE) | shift_step(pawns, 7, NOT_A_FILE)
+		: shift_step(pawns, -7, NOT_H_FILE) | shift_step(pawns, -9, NOT_A_FILE);
+}
+
+LANES_INLINE void lanes_attack_map(BitBoard * out, const BatchPieces * pieces, const BitBoard * empty, bool up, bool avx2) {
+	BitBoard fill[BOARD_BATCH_SIZE];
+	for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+		out[i] = pawn_pattern(pieces->pawns[i], up) | knight_pattern(pieces->knights[i]) | king_pattern(pieces->king[i]);
+	}
+	for (u8 d = 0; d < 8; ++d) {
+		lanes_fill(fill, directions[d].diagonal ? pieces->diagonal : pieces->straight, empty, &directions[d], avx2);
+		for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+			out[i] |= fill[i];
+		}
+	}
+}
+
+LANES_INLINE void batch_attack_maps(const BoardBatch * batch, BitBoard * white, BitBoard * black, bool avx2) {
+	BatchPieces own, enemy;
+	BitBoard empty[BOARD_BATCH_SIZE], own_map[BOARD_BATCH_SIZE], enemy_map[BOARD_BATCH_SIZE];
+	batch_pieces(batch, batch->own, &own);
+	batch_pieces(batch, batch->enemy, &enemy);
+	for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+		empty[i] = ~(batch->own[i] | batch->enemy[i]);
+	}
+	lanes_attack_map(own_map, &own, empty, true, avx2);
+	lanes_attack_map(enemy_map, &enemy, empty, false, avx2);
+	for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+		ChessSide side = batch->side[i];
+		BitBoard side_maps[2];
+		side_maps[side] = relative_bitboard(own_map[i], side);
+		side_maps[!side] = relative_bitboard(enemy_map[i], side);
+		white[i] = side_maps[WHITE_SIDE];
+		black[i] = side_maps[BLACK_SIDE];
+	}
+}
+
+LANES_INLINE u32 batch_checks(const BoardBatch * batch, bool avx2) {
+	BatchPieces enemy;
+	BitBoard empty[BOARD_BATCH_SIZE], enemy_map[BOARD_BATCH_SIZE];
+	batch_pieces(batch, batch->enemy, &enemy);
+	for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+		empty[i] = ~(batch->own[i] | batch->enemy[i]);
+	}
+	lanes_attack_map(enemy_map, &enemy, empty, false, avx2);
+	u32 checks = 0;
+	for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+		if (enemy_map[i] & batch->pieces[CHESS_KING][i] & batch->own[i])
+			checks |= (u32)1 << i;
+	}
+	return checks;
+}
+
+/* each promoting target is four moves */
+LANES_INLINE usize pawn_target_count(BitBoard targets) {
+	return bitboard_count(targets) + 3 * bitboard_count(targets & RANK_8);
+}
+
+static bool king_attacked(BitBoard king, BitBoard occupied, BitBoard pawns, BitBoard knights, BitBoard diagonal, BitBoard straight) {
+	if ((knight_pattern(king) & knights) || (pawn_pattern(king, true) & pawns))
+		return true;
+	for (u8 d = 0; d < 8; ++d) {
+		BitBoard sliders = directions[d].diagonal ? diagonal : straight;
+		if (slider_fill(king, ~occupied, directions[d].shift, directions[d].wrap) & sliders)
+			return true;
+	}
+	return false;
+}
+
+/* en passant lifts two pawns off one rank, so each capture is made on the occupancy and the king tested */
+static usize en_passant_count(const BoardBatch * batch, usize lane, const BatchPieces * own, const BatchPieces * enemy) {
+	const BitBoard target = batch->en_passant[lane];
+	const BitBoard captured = target >> 8;
+	BitBoard capturers = own->pawns[lane] & pawn_pattern(target, false);
+	usize count = 0;
+	while (capturers) {
+		BitBoard from = capturers & -capturers;
+		capturers ^= from;
+		BitBoard occupied = (batch->own[lane] | batch->enemy[lane]) ^ from ^ target ^ captured;
+		if (!king_attacked(own->king[lane], occupied, enemy->pawns[lane] & ~captured, enemy->knights[lane],
+			enemy->diagonal[lane], enemy->straight[lane]))
+			++count;
+	}
+	return count;
+}
+
+LANES_INLINE void batch_count_moves(const BoardBatch * batch, usize * counts, bool avx2) {
+	BatchPieces own, enemy;
+	BitBoard empty[BOARD_BATCH_SIZE], king_empty[BOARD_BATCH_SIZE], danger[BOARD_BATCH_SIZE];
+	BitBoard checkers[BOARD_BATCH_SIZE], check_mask[BOARD_BATCH_SIZE], targets[BOARD_BATCH_SIZE];
+	BitBoard pinned[BOARD_BATCH_SIZE], pin_lines[4][BOARD_BATCH_SIZE] = {0};
+	BitBoard enemy_rays[8][BOARD_BATCH_SIZE], rays[BOARD_BATCH_SIZE], fill[BOARD_BATCH_SIZE];
+	batch_pieces(batch, batch->own, &own);
+	batch_pieces(batch, batch->enemy, &enemy);
+	for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+		empty[i] = ~(batch->own[i] | batch->enemy[i]);
+		king_empty[i] = empty[i] | own.king[i];
+		danger[i] = pawn_pattern(enemy.pawns[i], false) | knight_pattern(enemy.knights[i]) | king_pattern(enemy.king[i]);
+		checkers[i] = (knight_pattern(own.king[i]) & enemy.knights[i]) | (pawn_pattern(own.king[i], true) & enemy.pawns[i]);
+		check_mask[i] = checkers[i];
+		pinned[i] = 0;
+	}
+	/* the king lifted, so squares behind it stay covered by the slider checking it */
+	for (u8 d = 0; d < 8; ++d) {
+		lanes_fill(enemy_rays[d], directions[d].diagonal ? enemy.diagonal : enemy.straight, king_empty, &directions[d], avx2);
+		for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+			danger[i] |= enemy_rays[d][i];
+		}
+	}
+
+	/* A ray out of the king meets the enemy rays coming the other way on the squares between the king
+	 * and a slider, so a lone own piece there is pinned. A ray reaching the slider itself is a check.
+	 * Directions come in opposite pairs, d ^ 1 is the reverse of d.
+	 */
+	for (u8 d = 0; d < 8; ++d) {
+		const Direction * dir = &directions[d];
+		const BitBoard * attackers = dir->diagonal ? enemy.diagonal : enemy.straight;
+		lanes_fill(rays, own.king, empty, dir, avx2);
+		for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+			BitBoard blocker = rays[i] & enemy_rays[d ^ 1][i] & batch->own[i];
+			pinned[i] |= blocker;
+			pin_lines[dir->axis][i] |= blocker;
+			if (rays[i] & attackers[i]) {
+				checkers[i] |= rays[i] & attackers[i];
+				check_mask[i] |= rays[i];
+			}
+		}
+	}
+
+	for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+		const BitBoard own_pieces = batch->own[i];
+		const BitBoard free = ~pinned[i];
+		u8 check_count = bitboard_count(checkers[i]);
+		/* in check only captures of the checker and blocks count, in double check only the king moves */
+		targets[i] = check_count == 0 ? ~own_pieces : check_count == 1 ? check_mask[i] & ~own_pieces : 0;
+		counts[i] = bitboard_count(king_pattern(own.king[i]) & ~own_pieces & ~danger[i]);
+		if (!checkers[i]) {
+			const BitBoard castles = batch->castles[i];
+			if ((castles & KING_SIDE_CASTLE_TARGET)
+				&& !(~empty[i] & KING_SIDE_CASTLE_PATH) && !(danger[i] & KING_SIDE_CASTLE_PATH))
+				++counts[i];
+			if ((castles & QUEEN_SIDE_CASTLE_TARGET)
+				&& !(~empty[i] & QUEEN_SIDE_CASTLE_EMPTY) && !(danger[i] & QUEEN_SIDE_CASTLE_PATH))
+				++counts[i];
+		}
+		/* a pinned knight never stays on its line */
+		const BitBoard knights = own.knights[i] & free;
+		for (u8 j = 0; j < 8; ++j) {
+			counts[i] += bitboard_count(shift_step(knights, knight_jumps[j].shift, knight_jumps[j].wrap) & targets[i]);
+		}
+		const BitBoard pawns = own.pawns[i];
+		BitBoard pushes = shift_step(pawns & (free | pin_lines[0][i]), 8, ~(BitBoard)0) & empty[i];
+		BitBoard double_pushes = shift_step(pushes & RANK_3, 8, ~(BitBoard)0) & empty[i];
+		counts[i] += pawn_target_count(pushes & targets[i]) + bitboard_count(double_pushes & targets[i]);
+		counts[i] += pawn_target_count(shift_step(pawns & (free | pin_lines[2][i]), 9, NOT_H_FILE) & batch->enemy[i] & targets[i]);
+		counts[i] += pawn_target_count(shift_step(pawns & (free | pin_lines[3][i]), 7, NOT_A_FILE) & batch->enemy[i] & targets[i]);
+		if (batch->en_passant[i])
+			counts[i] += en_passant_count(batch, i, &own, &enemy);
+	}
+
+	/* a slider's ray stops at the first own piece, so one direction's targets never overlap and popcounts add up */
+	for (u8 d = 0; d < 8; ++d) {
+		const Direction * dir = &directions[d];
+		const BitBoard * sliders = dir->diagonal ? own.diagonal : own.straight;
+		BitBoard movers[BOARD_BATCH_SIZE];
+		for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+			movers[i] = sliders[i] & (~pinned[i] | pin_lines[dir->axis][i]);
+		}
+		lanes_fill(fill, movers, empty, dir, avx2);
+		for (usize i = 0; i < BOARD_BATCH_SIZE; ++i) {
+			counts[i] += bitboard_count(fill[i] & targets[i]);
+		}
+	}
+}
+
+#ifdef CHESS_X86_KERNELS
+__attribute__((target("avx2")))
+static void batch_attack_maps_avx2(const BoardBatch * batch, BitBoard * white, BitBoard * black) {
+	batch_attack_maps(batch, white, black, true);
+}
+
+__attribute__((target("avx2")))
+static u32 batch_checks_avx2(const BoardBatch * batch) {
+	return batch_checks(batch, true);
+}
+
+__attribute__((target("avx2")))
+static void batch_count_moves_avx2(const BoardBatch * batch, usize * counts) {
+	batch_count_moves(batch, counts, true);
+}
+#endif
+
+void board_batch_attack_maps(const BoardBatch * batch, BitBoard white[BOARD_BATCH_SIZE], BitBoard black[BOARD_BATCH_SIZE]) {
+#ifdef CHESS_X86_KERNELS
+	if (chess_get_kernel() == CHESS_KERNEL_AVX2) {
+		batch_attack_maps_avx2(batch, white, black);
+		return;
+	}
+#endif
+	batch_attack_maps(batch, white, black, false);
+}
+
+u32 board_batch_checks(const BoardBatch * batch) {
+#ifdef CHESS_X86_KERNELS
+	if (chess_get_kernel() == CHESS_KERNEL_AVX2)
+		return batch_checks_avx2(batch);
+#endif
+	return batch_checks(batch, false);
+}
+
+void board_batch_count_moves(const BoardBatch * batch, usize counts[BOARD_BATCH_SIZE]) {
+#ifdef CHESS_X86_KERNELS
+	if (chess_get_kernel() == CHESS_KERNEL_AVX2) {
+		batch_count_moves_avx2(batch, counts);
+		return;
+	}
+#endif
+	batch_count_moves(batch, counts, false);
+}
@@ -3,59 +3,294 @@
 #include <SDL3/SDL_assert.h>
 #include <SDL3/SDL_log.h>
 
-static bool rel_pos_in_bounds(Vec2i relpos) {
-	return relpos.x >= 0 && relpos.x < 8
-		&& relpos.y >= 0 && relpos.y < 8;
+#ifndef CHESS_MAILBOX
+/* Fancy magic slider lookup.
+ * mask is the ray set from the square minus the board edges,
+ * so (occupied & mask) * magic >> shift is a perfect index
+ * into that square's slice of the shared attack table, starting at offset.
+ * Under CHESS_X86_KERNELS the PEXT tables hold the same slices indexed by the mask bits of occupied, in order.
+ */
+typedef struct {
+	BitBoard mask;
+	BitBoard magic;
+	u32 offset;
+	u8 shift;
+} SliderMagic;
+#endif
+
+/* Generated by tools/gen_tables.c, see the Makefile, so the tables below live in .rodata
+ * and no process pays to build them at startup.
+ *
+ * knight, king and pawn attack tables: squares attacked from each index, pawns indexed by the side of the attacking pawn
+ * between_table: squares strictly between two indexes sharing a line, otherwise empty
+ * line_table: the whole board-wide line through two such indexes, otherwise empty
+ * pawn_push_square: the square one step forward for a pawn of that side, INVALID_PIECE_IDX off the board
+ * bishop and rook magics with their attack and PEXT tables, left out of mailbox builds
+ *
+ * Zobrist keys, castle rights are indexed king side first.
+ * zobrist_initial is the raw key of INITIAL_CHESS_BOARD and is folded into every key,
+ * so the starting position hashes to 0 and INITIAL_CHESS_BOARD can carry it as a constant.
+ */
+#include "include/chess_tables.h"
+
+static BitBoard idx_to_bitboard(u8 idx) {
+	return (BitBoard)1 << idx;
 }
 
-static Vec2i idx_to_rel_pos(u8 idx, ChessSide side) {
-	int x = idx % 8;
-	int y = idx / 8;
-	if (side == BLACK_SIDE) {
-		x =  7 - x;
-		y = 7 - y;
-	}
-	return vec2i_new(x, y);
+/* INVARIANT: idx is empty */
+static void place_piece(ChessBoard * board, u8 idx, ChessSide side, ChessPiece piece) {
+	BitBoard bit = idx_to_bitboard(idx);
+	board->slots[idx] = (BoardSlot){ .has_piece = true, .side = side, .piece = piece };
+	board->hash ^= zobrist_pieces[side][piece][idx];
+	SDL_assert(board->piece_lists[side].count < CHESS_SIDE_PIECE_LIMIT);
+	board->piece_list_slot[idx] = board->piece_lists[side].count;
+	board->piece_lists[side].squares[board->piece_lists[side].count++] = idx;
+	board->bitboards.sides[side] |= bit;
+	board->bitboards.pieces[piece] |= bit;
+	board->bitboards.occupied |= bit;
 }
 
-static u8 rel_pos_to_idx(Vec2i relpos, ChessSide side) {
-	if (side == BLACK_SIDE) {
-		relpos.x = 7 - relpos.x;
-		relpos.y = 7 - relpos.y;
-	}
-	return relpos.y * 8 + relpos.x;
+/* INVARIANT: idx holds a piece */
+static void remove_piece(ChessBoard * board, u8 idx) {
+	BoardSlot slot = board->slots[idx];
+	BitBoard bit = idx_to_bitboard(idx);
+	board->bitboards.sides[slot.side] &= ~bit;
+	board->bitboards.pieces[slot.piece] &= ~bit;
+	board->bitboards.occupied &= ~bit;
+	board->hash ^= zobrist_pieces[slot.side][slot.piece][idx];
+	/* the last square of the list fills the gap */
+	u8 list_slot = board->piece_list_slot[idx];
+	u8 last = board->piece_lists[slot.side].squares[--board->piece_lists[slot.side].count];
+	board->piece_lists[slot.side].squares[list_slot] = last;
+	board->piece_list_slot[last] = list_slot;
+	board->slots[idx] = EMPTY_SLOT;
+}
+
+/* INVARIANT: idx holds a piece */
+static void change_piece_type(ChessBoard * board, u8 idx, ChessPiece piece) {
+	BoardSlot * slot = &board->slots[idx];
+	BitBoard bit = idx_to_bitboard(idx);
+	board->bitboards.pieces[slot->piece] &= ~bit;
+	board->bitboards.pieces[piece] |= bit;
+	board->hash ^= zobrist_pieces[slot->side][slot->piece][idx] ^ zobrist_pieces[slot->side][piece][idx];
+	slot->piece = piece;
 }
 
+/* INVARIANT: src holds a piece and dest is empty */
 static void transfer_to_slot(ChessBoard * board, u8 src, u8 dest) {
-	board->slots[dest] = board->slots[src];
+	BoardSlot slot = board->slots[src];
+	BitBoard mask = idx_to_bitboard(src) | idx_to_bitboard(dest);
+	board->bitboards.sides[slot.side] ^= mask;
+	board->bitboards.pieces[slot.piece] ^= mask;
+	board->bitboards.occupied ^= mask;
+	board->hash ^= zobrist_pieces[slot.side][slot.piece][src] ^ zobrist_pieces[slot.side][slot.piece][dest];
+	board->piece_list_slot[dest] = board->piece_list_slot[src];
+	board->piece_lists[slot.side].squares[board->piece_list_slot[dest]] = dest;
+	board->slots[dest] = slot;
 	board->slots[src] = EMPTY_SLOT;
 }
 
-static bool is_promoting_pawn_at_idx(ChessBoard * board, u8 idx) {
-	const u8 white_promoting_y = 7;
-	const u8 black_promoting_y = 0;
-	BoardSlot * slot = &board->slots[idx];
-	if (slot->piece != CHESS_PAWN) {
+#ifdef CHESS_MAILBOX
+/* 10x12 mailbox layout, built with -DCHESS_MAILBOX to benchmark against the magic lookup.
+ * The 8x8 board sits inside a border two ranks deep and one file wide,
+ * mailbox120 holds the board index of each cell or -1 for the border,
+ * mailbox64 maps a board index to its cell, and a step is dy * 10 + dx.
+ * A ray walk stops at the first border cell, so no coordinate is ever bounds checked.
+ */
+static const i8 mailbox120[120] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1,  0,  1,  2,  3,  4,  5,  6,  7, -1,
+	-1,  8,  9, 10, 11, 12, 13, 14, 15, -1,
+	-1, 16, 17, 18, 19, 20, 21, 22, 23, -1,
+	-1, 24, 25, 26, 27, 28, 29, 30, 31, -1,
+	-1, 32, 33, 34, 35, 36, 37, 38, 39, -1,
+	-1, 40, 41, 42, 43, 44, 45, 46, 47, -1,
+	-1, 48, 49, 50, 51, 52, 53, 54, 55, -1,
+	-1, 56, 57, 58, 59, 60, 61, 62, 63, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+static const u8 mailbox64[64] = {
+	21, 22, 23, 24, 25, 26, 27, 28,
+	31, 32, 33, 34, 35, 36, 37, 38,
+	41, 42, 43, 44, 45, 46, 47, 48,
+	51, 52, 53, 54, 55, 56, 57, 58,
+	61, 62, 63, 64, 65, 66, 67, 68,
+	71, 72, 73, 74, 75, 76, 77, 78,
+	81, 82, 83, 84, 85, 86, 87, 88,
+	91, 92, 93, 94, 95, 96, 97, 98,
+};
+
+static const i8 mailbox_bishop_steps[4] = { 11, -11, 9, -9 };
+static const i8 mailbox_rook_steps[4] = { 1, -1, 10, -10 };
+#endif
+
+/* relative ranks of the double push start and of promotion, per side */
+static const BitBoard pawn_start_rank[2] = {
+	[WHITE_SIDE] = 0x000000000000FF00,
+	[BLACK_SIDE] = 0x00FF000000000000,
+};
+static const BitBoard pawn_promotion_rank[2] = {
+	[WHITE_SIDE] = 0xFF00000000000000,
+	[BLACK_SIDE] = 0x00000000000000FF,
+};
+
+static ChessKernel chess_kernel = CHESS_KERNEL_SCALAR;
+
+#ifndef CHESS_MAILBOX
+#ifdef CHESS_X86_KERNELS
+/* set with the kernel, checked per lookup since the branch always goes the same way */
+static bool slider_pext = false;
+
+/* inline asm instead of the intrinsic, so the lookup still inlines into code built without -mbmi2 */
+static BitBoard pext_u64(BitBoard src, BitBoard mask) {
+	BitBoard result;
+	__asm__("pextq %2, %1, %0" : "=r"(result) : "r"(src), "r"(mask));
+	return result;
+}
+#endif
+
+static BitBoard bishop_attacks(u8 idx, BitBoard occupied) {
+	const SliderMagic * m = &bishop_magics[idx];
+#ifdef CHESS_X86_KERNELS
+	if (slider_pext)
+		return bishop_pext_table[m->offset + pext_u64(occupied, m->mask)];
+#endif
+	return bishop_attack_table[m->offset + (((occupied & m->mask) * m->magic) >> m->shift)];
+}
+
+static BitBoard rook_attacks(u8 idx, BitBoard occupied) {
+	const SliderMagic * m = &rook_magics[idx];
+#ifdef CHESS_X86_KERNELS
+	if (slider_pext)
+		return rook_pext_table[m->offset + pext_u64(occupied, m->mask)];
+#endif
+	return rook_attack_table[m->offset + (((occupied & m->mask) * m->magic) >> m->shift)];
+}
+#else
+/* walks each step until the border or the first occupied square (inclusive) */
+static BitBoard mailbox_slider_attacks(u8 idx, BitBoard occupied, const i8 steps[4]) {
+	BitBoard attacks = 0;
+	for (u8 i = 0; i < 4; ++i) {
+		i8 to;
+		for (u8 cell = mailbox64[idx] + steps[i]; (to = mailbox120[cell]) != -1; cell += steps[i]) {
+			attacks |= idx_to_bitboard(to);
+			if (occupied & idx_to_bitboard(to))
+				break;
+		}
+	}
+	return attacks;
+}
+
+static BitBoard bishop_attacks(u8 idx, BitBoard occupied) {
+	return mailbox_slider_attacks(idx, occupied, mailbox_bishop_steps);
+}
+
+static BitBoard rook_attacks(u8 idx, BitBoard occupied) {
+	return mailbox_slider_attacks(idx, occupied, mailbox_rook_steps);
+}
+#endif
+
+ChessKernel chess_detect_kernel(void) {
+#ifdef CHESS_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("bmi2")) {
+		return __builtin_cpu_supports("avx2") ? CHESS_KERNEL_AVX2 : CHESS_KERNEL_BMI2;
+	}
+#endif
+	return CHESS_KERNEL_SCALAR;
+}
+
+const char * chess_kernel_str(ChessKernel kernel) {
+	switch (kernel) {
+	case CHESS_KERNEL_SCALAR:
+		return "scalar";
+	case CHESS_KERNEL_BMI2:
+		return "bmi2";
+	case CHESS_KERNEL_AVX2:
+		return "avx2";
+	}
+	return "unknown";
+}
+
+bool chess_set_kernel(ChessKernel kernel) {
+	if (kernel > chess_detect_kernel())
 		return false;
+	chess_kernel = kernel;
+#if defined(CHESS_X86_KERNELS) && !defined(CHESS_MAILBOX)
+	slider_pext = kernel >= CHESS_KERNEL_BMI2;
+#endif
+	return true;
+}
+
+ChessKernel chess_get_kernel(void) {
+	return chess_kernel;
+}
+
+/* the best kernel the CPU has, unless CHESS_KERNEL names another one it can run */
+static void chess_select_kernel(void) {
+	ChessKernel detected = chess_detect_kernel();
+	ChessKernel kernel = detected;
+	const char * requested = SDL_getenv("CHESS_KERNEL");
+	if (requested) {
+		ChessKernel k;
+		for (k = CHESS_KERNEL_SCALAR; k <= CHESS_KERNEL_AVX2; ++k) {
+			if (SDL_strcmp(requested, chess_kernel_str(k)) == 0)
+				break;
+		}
+		if (k > CHESS_KERNEL_AVX2) {
+			SDL_Log("CHESS_KERNEL=%s is not one of scalar, bmi2 or avx2, ignoring it", requested);
+		} else if (k > detected) {
+			SDL_Log("CHESS_KERNEL=%s is not supported by this CPU, ignoring it", requested);
+		} else {
+			kernel = k;
+		}
 	}
-	u8 piece_y = idx / 8;
-	if (slot->side == WHITE_SIDE) {
-		return piece_y == white_promoting_y;
-	} else {
-		return piece_y == black_promoting_y;
+	chess_set_kernel(kernel);
+	SDL_Log("Chess kernel: %s (CPU supports up to %s)", chess_kernel_str(kernel), chess_kernel_str(detected));
+}
+
+void chess_init(void) {
+	chess_select_kernel();
+}
+
+/* the castling and en passant part of the key */
+static u64 zobrist_state_key(const ChessBoard * board) {
+	u64 hash = 0;
+	for (u8 side = 0; side < 2; ++side) {
+		if (board->sides[side].ks_castle_ok)
+			hash ^= zobrist_castle[side][0];
+		if (board->sides[side].qs_castle_ok)
+			hash ^= zobrist_castle[side][1];
 	}
+	if (board->opt_pawn != INVALID_PIECE_IDX)
+		hash ^= zobrist_en_passant[board->opt_pawn % 8];
+	return hash;
 }
 
-static bool is_free_idx(ChessBoard * board, u8 idx) {
-	return !board->slots[idx].has_piece;
+static void flip_side(ChessBoard * board) {
+	board->side ^= 1;
+	board->hash ^= zobrist_black_to_move;
 }
 
-static bool is_enemy_idx(ChessBoard * board, u8 idx, ChessSide side) {
-	return board->slots[idx].has_piece && board->slots[idx].side != side;
+u64 board_compute_hash(const ChessBoard * board) {
+	u64 hash = zobrist_initial ^ zobrist_state_key(board);
+	BitBoard occupied = board->bitboards.occupied;
+	while (occupied) {
+		u8 idx = bitboard_pop_lsb(&occupied);
+		const BoardSlot * slot = &board->slots[idx];
+		hash ^= zobrist_pieces[slot->side][slot->piece][idx];
+	}
+	if (board->side == BLACK_SIDE)
+		hash ^= zobrist_black_to_move;
+	return hash;
 }
 
-static bool is_free_or_enemy_idx(ChessBoard * board, u8 idx, ChessSide side) {
-	return !board->slots[idx].has_piece || board->slots[idx].side != side;
+static bool is_promoting_pawn_at_idx(ChessBoard * board, u8 idx) {
+	BoardSlot * slot = &board->slots[idx];
+	return slot->piece == CHESS_PAWN && (pawn_promotion_rank[slot->side] & idx_to_bitboard(idx));
 }
 
 /* INVARIANT: from is a CHESS_PAWN */
@@ -83,6 +318,8 @@ static BoardMoveResult board_make_move_internal(ChessBoard * board, u8 from, u8
 		.cancelled_op_ks_castle = false,
 		.cancelled_op_qs_castle = false,
 	};
+	/* pieces are hashed by the slot helpers, castling and en passant are swapped out as a whole */
+	board->hash ^= zobrist_state_key(board);
 	board->opt_pawn = INVALID_PIECE_IDX;
 	if (board->slots[from].piece == CHESS_KING) {
 		board->sides[board->side].king_idx = to;
@@ -138,28 +375,27 @@ static BoardMoveResult board_make_move_internal(ChessBoard * board, u8 from, u8
 	} else if (board->slots[from].piece == CHESS_PAWN) {
 		if (is_pawn_enpassant_move(board, from, to)) {
 			result.en_passant = true;
-			ChessSide side = board->side;
-			Vec2i to_pos = idx_to_rel_pos(to, side);
-			to_pos.y -= 1;
-			result.captured = rel_pos_to_idx(to_pos, side);
+			/* the captured pawn sits one step behind the target, seen from the mover */
+			result.captured = pawn_push_square[!board->side][to];
 		} else if (absi(from - to) == 16) {
 			board->opt_pawn = to;
 		}
 	}
 	if (board->slots[result.captured].has_piece) {
 		result.capture = true;
-		result.piece = board->slots[to].piece;
-		board->slots[result.captured] = EMPTY_SLOT;
+		result.piece = board->slots[result.captured].piece;
+		remove_piece(board, result.captured);
+		/* only flag rights that were still held, or unmaking would grant new ones */
 		if (result.captured == INITIAL_WHITE_KING_SIDE_ROOK_IDX && board->sides[WHITE_SIDE].ks_castle_ok) {
 			board->sides[WHITE_SIDE].ks_castle_ok = false;
 			result.cancelled_op_ks_castle = true;
-		} else if (result.captured == INITIAL_WHITE_QUEEN_SIDE_ROOK_IDX) {
+		} else if (result.captured == INITIAL_WHITE_QUEEN_SIDE_ROOK_IDX && board->sides[WHITE_SIDE].qs_castle_ok) {
 			board->sides[WHITE_SIDE].qs_castle_ok = false;
 			result.cancelled_op_qs_castle = true;
-		} else if (result.captured == INITIAL_BLACK_KING_SIDE_ROOK_IDX) {
+		} else if (result.captured == INITIAL_BLACK_KING_SIDE_ROOK_IDX && board->sides[BLACK_SIDE].ks_castle_ok) {
 			board->sides[BLACK_SIDE].ks_castle_ok = false;
 			result.cancelled_op_ks_castle = true;
-		} else if (result.captured == INITIAL_BLACK_QUEEN_SIDE_ROOK_IDX) {
+		} else if (result.captured == INITIAL_BLACK_QUEEN_SIDE_ROOK_IDX && board->sides[BLACK_SIDE].qs_castle_ok) {
 			board->sides[BLACK_SIDE].qs_castle_ok = false;
 			result.cancelled_op_qs_castle = true;
 		}
@@ -168,10 +404,13 @@ static BoardMoveResult board_make_move_internal(ChessBoard * board, u8 from, u8
 	if (is_promoting_pawn_at_idx(board, to)) {
 		result.promotion = true;
 	}
+	board->hash ^= zobrist_state_key(board);
+	SDL_assert_paranoid(board->hash == board_compute_hash(board));
 	return result;
 }
 
 static void board_unmake_move_internal(ChessBoard * board, BoardMoveResult last_move) {
+	board->hash ^= zobrist_state_key(board);
 	board->opt_pawn = last_move.last_opt_pawn;
 	transfer_to_slot(board, last_move.to, last_move.from);
 	if (board->slots[last_move.from].piece == CHESS_KING) {
@@ -179,14 +418,10 @@ static void board_unmake_move_internal(ChessBoard * board, BoardMoveResult last_
 	}
 	if (last_move.capture) {
 		ChessSide side = board->side == WHITE_SIDE ? BLACK_SIDE : WHITE_SIDE;
-		board->slots[last_move.captured] = (BoardSlot){
-			.side = side,
-			.has_piece = true,
-			.piece = last_move.piece,
-		};
+		place_piece(board, last_move.captured, side, last_move.piece);
 	}
 	if (last_move.promotion) {
-		board->slots[last_move.from].piece = CHESS_PAWN;
+		change_piece_type(board, last_move.from, CHESS_PAWN);
 	}
 	if (last_move.castle) {
 		if (last_move.to == WHITE_KING_SIDE_CASTLE_IDX) {
@@ -212,6 +447,8 @@ static void board_unmake_move_internal(ChessBoard * board, BoardMoveResult last_
 	if (last_move.cancelled_op_qs_castle) {
 		board->sides[op].qs_castle_ok = true;
 	}
+	board->hash ^= zobrist_state_key(board);
+	SDL_assert_paranoid(board->hash == board_compute_hash(board));
 }
 
 BoardMoveResult board_make_move(ChessBoard * board, u8 from, u8 to) {
@@ -222,354 +459,1005 @@ BoardMoveResult board_make_move(ChessBoard * board, u8 from, u8 to) {
 		board->half_moves = 0;
 	else
 		++board->half_moves;
-	board->side ^= 1;
+	flip_side(board);
 	return result;
 }
 
-usize board_count_moves(ChessBoard * board, usize depth) {
-	if (depth == 0)
-		return 1;
-	usize count = 0;
-	for (u8 i = 0; i < 64; ++i) {
-		BoardSlot * slot = &board->slots[i];
-		if (!slot->has_piece || slot->side != board->side) {
-			continue;
-		}
-		LegalBoardMoves moves = board_get_legal_moves_for_piece(board, i);
-		for (u8 j = 0; j < 64; ++j) {
-			if (legal_board_moves_contains_idx(moves, j)) {
-				BoardMoveResult res = board_make_move_internal(board, i, j);
-				board->side ^= 1;
-				if (!res.promotion) {
-					count += board_count_moves(board, depth - 1);
-				} else {
-					board->slots[res.to].piece = CHESS_KNIGHT;
-					count += board_count_moves(board, depth - 1);
-					board->slots[res.to].piece = CHESS_BISHOP;
-					count += board_count_moves(board, depth - 1);
-					board->slots[res.to].piece = CHESS_ROOK;
-					count += board_count_moves(board, depth - 1);
-					board->slots[res.to].piece = CHESS_QUEEN;
-					count += board_count_moves(board, depth - 1);
-					board->slots[res.to].piece = CHESS_PAWN;
-				}
-				board->side ^= 1;
-				board_unmake_move_internal(board, res);
-			}
-		}
-	}
-	return count;
+void board_unmake_move(ChessBoard * board, BoardMoveResult last_move, usize half_moves) {
+	flip_side(board);
+	board_unmake_move_internal(board, last_move);
+	if (board->side == BLACK_SIDE)
+		--board->full_moves;
+	board->half_moves = half_moves;
 }
 
-static bool king_in_bishop_LOS(const ChessBoard * const board, const Vec2i * kpos, const Vec2i * dpos, ChessSide side) {
-	if (absi(dpos->x) != absi(dpos->y))
+void board_history_init(BoardHistory * history, usize limit) {
+	history->entries = NULL;
+	history->capacity = 0;
+	history->head = 0;
+	history->count = 0;
+	history->limit = limit;
+}
+
+void board_history_clear(BoardHistory * history) {
+	history->head = 0;
+	history->count = 0;
+}
+
+void board_history_free(BoardHistory * history) {
+	SDL_free(history->entries);
+	board_history_init(history, history->limit);
+}
+
+/* unrolls the ring into a larger buffer, oldest entry first */
+static bool board_history_grow(BoardHistory * history) {
+	usize capacity = history->capacity ? history->capacity * 2 : 64;
+	if (history->limit && capacity > history->limit)
+		capacity = history->limit;
+	BoardHistoryEntry * entries = SDL_malloc(capacity * sizeof(*entries));
+	if (!entries)
 		return false;
-	for (int i = 1; i < absi(dpos->x); ++i) {
-		int x = i * getsigni(dpos->x) + kpos->x;
-		int y = i * getsigni(dpos->y) + kpos->y;
-		u8 path_idx = rel_pos_to_idx(vec2i_new(x, y), side);
-		if (board->slots[path_idx].has_piece) {
-			return false;
-		}
+	for (usize i = 0; i < history->count; ++i) {
+		entries[i] = history->entries[(history->head + i) % history->capacity];
 	}
+	SDL_free(history->entries);
+	history->entries = entries;
+	history->capacity = capacity;
+	history->head = 0;
 	return true;
 }
 
-static bool king_in_rook_LOS(const ChessBoard * const board, const Vec2i * kpos, const Vec2i * dpos, ChessSide side) {
-	if (dpos->x == 0) {
-		for (int i = 1; i < absi(dpos->y); ++i) {
-			int x = kpos->x;
-			int y = i * getsigni(dpos->y) + kpos->y;
-			u8 path_idx = rel_pos_to_idx(vec2i_new(x, y), side);
-			if (board->slots[path_idx].has_piece) {
-				return false;
-			}
-		}
+/* makes room for one more entry, a full limited history has room by dropping its oldest */
+static bool board_history_reserve(BoardHistory * history) {
+	if (history->count < history->capacity || (history->limit && history->capacity == history->limit))
 		return true;
-	}
-	if (dpos->y == 0) {
-		for (int i = 1; i < absi(dpos->x); ++i) {
-			int y = kpos->y;
-			int x = i * getsigni(dpos->x) + kpos->x;
-			u8 path_idx = rel_pos_to_idx(vec2i_new(x, y), side);
-			if (board->slots[path_idx].has_piece) {
-				return false;
-			}
-		}
+	return board_history_grow(history);
+}
+
+bool board_history_push(BoardHistory * history, BoardMoveResult result, usize half_moves) {
+	BoardHistoryEntry entry = { .result = result, .half_moves = half_moves };
+	if (!board_history_reserve(history))
+		return false;
+	if (history->count == history->capacity) {
+		/* full, the newest entry takes the oldest one's slot */
+		history->entries[history->head] = entry;
+		history->head = (history->head + 1) % history->capacity;
 		return true;
 	}
-	return false;
+	history->entries[(history->head + history->count) % history->capacity] = entry;
+	++history->count;
+	return true;
+}
+
+bool board_history_pop(BoardHistory * history, BoardHistoryEntry * out) {
+	if (history->count == 0)
+		return false;
+	--history->count;
+	*out = history->entries[(history->head + history->count) % history->capacity];
+	return true;
+}
+
+const BoardHistoryEntry * board_history_get(const BoardHistory * history, usize i) {
+	SDL_assert(i < history->count);
+	return &history->entries[(history->head + i) % history->capacity];
+}
+
+bool board_history_make_move(BoardHistory * history, ChessBoard * board, u8 from, u8 to, BoardMoveResult * result) {
+	/* reserve first so a failed push never leaves an unrecorded move on the board */
+	if (!board_history_reserve(history))
+		return false;
+	usize half_moves = board->half_moves;
+	*result = board_make_move(board, from, to);
+	return board_history_push(history, *result, half_moves);
+}
+
+bool board_history_undo(BoardHistory * history, ChessBoard * board) {
+	BoardHistoryEntry entry;
+	if (!board_history_pop(history, &entry))
+		return false;
+	board_unmake_move(board, entry.result, entry.half_moves);
+	return true;
+}
+
+void board_set_promotion_type(ChessBoard * board, u8 idx, ChessPiece piece) {
+	SDL_assert(board->slots[idx].has_piece && board->slots[idx].piece != CHESS_KING);
+	change_piece_type(board, idx, piece);
+}
+
+void board_place_piece(ChessBoard * board, u8 idx, ChessSide side, ChessPiece piece) {
+	SDL_assert(!board->slots[idx].has_piece);
+	place_piece(board, idx, side, piece);
+	if (piece == CHESS_KING) {
+		board->sides[side].king_idx = idx;
+	}
+}
+
+/* Per position legality state for one side.
+ * Any non king move must land in check_mask,
+ * and a pinned piece must also stay on the line through its king.
+ */
+typedef struct {
+	BitBoard checkers;
+	BitBoard check_mask;
+	BitBoard pinned;
+	u8 king_idx;
+	ChessSide side;
+} MoveGenContext;
+
+/* every piece of either side attacking idx, sliders see through anything not in occupied */
+static BitBoard attackers_to(const ChessBoard * board, u8 idx, BitBoard occupied) {
+	const BitBoard * pieces = board->bitboards.pieces;
+	const BitBoard * sides = board->bitboards.sides;
+	BitBoard diagonal = pieces[CHESS_BISHOP] | pieces[CHESS_QUEEN];
+	BitBoard straight = pieces[CHESS_ROOK] | pieces[CHESS_QUEEN];
+	return (pawn_attack_table[WHITE_SIDE][idx] & pieces[CHESS_PAWN] & sides[BLACK_SIDE])
+		| (pawn_attack_table[BLACK_SIDE][idx] & pieces[CHESS_PAWN] & sides[WHITE_SIDE])
+		| (knight_attack_table[idx] & pieces[CHESS_KNIGHT])
+		| (king_attack_table[idx] & pieces[CHESS_KING])
+		| (bishop_attacks(idx, occupied) & diagonal)
+		| (rook_attacks(idx, occupied) & straight);
+}
+
+static BitBoard legal_target_mask(const MoveGenContext * ctx, u8 from) {
+	BitBoard mask = ctx->check_mask;
+	if (ctx->pinned & idx_to_bitboard(from)) {
+		mask &= line_table[ctx->king_idx][from];
+	}
+	return mask;
+}
+
+/* en passant removes two pieces from one rank, so pins are verified directly */
+static bool en_passant_is_legal(const ChessBoard * board, const MoveGenContext * ctx, u8 from, u8 to) {
+	BitBoard captured = idx_to_bitboard(board->opt_pawn);
+	BitBoard occupied = (board->bitboards.occupied ^ idx_to_bitboard(from) ^ captured) | idx_to_bitboard(to);
+	BitBoard enemy = board->bitboards.sides[!ctx->side] & ~captured;
+	return (attackers_to(board, ctx->king_idx, occupied) & enemy) == 0;
+}
+
+/* a pawn's targets from the tables alone, en passant included, without legality */
+static BitBoard pawn_pseudo_targets(const ChessBoard * board, ChessSide side, u8 from) {
+	BitBoard empty = ~board->bitboards.occupied;
+	u8 push = pawn_push_square[side][from];
+	BitBoard targets = idx_to_bitboard(push) & empty;
+	if (targets && (pawn_start_rank[side] & idx_to_bitboard(from))) {
+		targets |= idx_to_bitboard(pawn_push_square[side][push]) & empty;
+	}
+	BitBoard captures = board->bitboards.sides[!side];
+	if (board->opt_pawn != INVALID_PIECE_IDX) {
+		captures |= idx_to_bitboard(pawn_push_square[side][board->opt_pawn]);
+	}
+	return targets | (pawn_attack_table[side][from] & captures);
+}
+
+static LegalBoardMoves knight_moves(ChessBoard * board, const MoveGenContext * ctx, u8 from) {
+	BitBoard targets = knight_attack_table[from] & ~board->bitboards.sides[ctx->side];
+	return targets & legal_target_mask(ctx, from);
+}
+
+static LegalBoardMoves bishop_moves(ChessBoard * board, const MoveGenContext * ctx, u8 from) {
+	BitBoard targets = bishop_attacks(from, board->bitboards.occupied) & ~board->bitboards.sides[ctx->side];
+	return targets & legal_target_mask(ctx, from);
+}
+
+static LegalBoardMoves rook_moves(ChessBoard * board, const MoveGenContext * ctx, u8 from) {
+	BitBoard targets = rook_attacks(from, board->bitboards.occupied) & ~board->bitboards.sides[ctx->side];
+	return targets & legal_target_mask(ctx, from);
+}
+
+static LegalBoardMoves queen_moves(ChessBoard * board, const MoveGenContext * ctx, u8 from) {
+	BitBoard occupied = board->bitboards.occupied;
+	BitBoard targets = (bishop_attacks(from, occupied) | rook_attacks(from, occupied))
+		& ~board->bitboards.sides[ctx->side];
+	return targets & legal_target_mask(ctx, from);
+}
+
+static void move_list_push(MoveList * list, u8 from, u8 to, u8 flags) {
+	list->moves[list->count++] = board_move_new(from, to, flags);
+}
+
+/* Instantiates the side dependent part of move generation for one side,
+ * every side test and side indexed constant folds away in each copy.
+ * board_generate_moves and friends pick a copy once per node.
+ *   square_attacked_NAME: whether the opponent of SIDE attacks idx, sliders seeing through anything not in occupied,
+ *     probing pawn, knight and king patterns first, then the eight rays up to their first blocker
+ *   movegen_context_init_NAME: checkers, check mask and pins for the king of SIDE
+ *   pawn_moves_NAME, king_castle_moves_NAME, king_step_moves_NAME, king_moves_NAME, piece_legal_moves_NAME: legal targets of one piece
+ *   has_any_legal_move_NAME: whether SIDE can move at all, king first and stopping at the first move found
+ *   push_piece_moves_NAME, generate_moves_NAME: every legal packed move of SIDE
+ *   generate_stage_moves_NAME: the noisy or the quiet part of generate_moves_NAME, for staged picking
+ *   generate_pseudo_moves_NAME: generate_moves_NAME without the legality checks
+ *   count_leaf_moves_NAME: the number of legal moves of SIDE, counted by popcount without making them
+ */
+#define DEFINE_SIDE_MOVEGEN(NAME, SIDE, KS_ROOK_IDX, QS_ROOK_IDX, KS_CASTLE_IDX, QS_CASTLE_IDX) \
+static bool square_attacked_##NAME(const ChessBoard * board, u8 idx, BitBoard occupied) { \
+	const BitBoard * pieces = board->bitboards.pieces; \
+	const BitBoard enemy = board->bitboards.sides[!(SIDE)]; \
+	if (pawn_attack_table[SIDE][idx] & pieces[CHESS_PAWN] & enemy) \
+		return true; \
+	if (knight_attack_table[idx] & pieces[CHESS_KNIGHT] & enemy) \
+		return true; \
+	if (king_attack_table[idx] & pieces[CHESS_KING] & enemy) \
+		return true; \
+	if (bishop_attacks(idx, occupied) & (pieces[CHESS_BISHOP] | pieces[CHESS_QUEEN]) & enemy) \
+		return true; \
+	return (rook_attacks(idx, occupied) & (pieces[CHESS_ROOK] | pieces[CHESS_QUEEN]) & enemy) != 0; \
+} \
+\
+static void movegen_context_init_##NAME(MoveGenContext * ctx, const ChessBoard * board) { \
+	const BitBoard * pieces = board->bitboards.pieces; \
+	BitBoard own = board->bitboards.sides[SIDE]; \
+	BitBoard enemy = board->bitboards.sides[!(SIDE)]; \
+	BitBoard occupied = board->bitboards.occupied; \
+	u8 king = board->sides[SIDE].king_idx; \
+	ctx->side = SIDE; \
+	ctx->king_idx = king; \
+	ctx->checkers = attackers_to(board, king, occupied) & enemy; \
+	switch (bitboard_count(ctx->checkers)) { \
+	case 0: \
+		ctx->check_mask = ~(BitBoard)0; \
+		break; \
+	case 1: { \
+		u8 checker = (u8)__builtin_ctzll(ctx->checkers); \
+		ctx->check_mask = ctx->checkers | between_table[king][checker]; \
+		break; \
+	} \
+	default: /* double check, only the king can move */ \
+		ctx->check_mask = 0; \
+		break; \
+	} \
+	/* enemy sliders that would see the king through exactly one of our pieces */ \
+	BitBoard snipers = \
+		(bishop_attacks(king, enemy) & (pieces[CHESS_BISHOP] | pieces[CHESS_QUEEN]) & enemy) \
+		| (rook_attacks(king, enemy) & (pieces[CHESS_ROOK] | pieces[CHESS_QUEEN]) & enemy); \
+	ctx->pinned = 0; \
+	while (snipers) { \
+		u8 sniper = bitboard_pop_lsb(&snipers); \
+		BitBoard blockers = between_table[king][sniper] & occupied; \
+		if (bitboard_count(blockers) == 1 && (blockers & own)) { \
+			ctx->pinned |= blockers; \
+		} \
+	} \
+} \
+\
+/* INVARIANT: a pawn is never on its own promotion rank, so the push square exists */ \
+static LegalBoardMoves pawn_moves_##NAME(ChessBoard * board, const MoveGenContext * ctx, u8 from) { \
+	BitBoard empty = ~board->bitboards.occupied; \
+	BitBoard attacks = pawn_attack_table[SIDE][from]; \
+	u8 push = pawn_push_square[SIDE][from]; \
+	BitBoard targets = idx_to_bitboard(push) & empty; \
+	if (targets && (pawn_start_rank[SIDE] & idx_to_bitboard(from))) { \
+		targets |= idx_to_bitboard(pawn_push_square[SIDE][push]) & empty; \
+	} \
+	targets |= attacks & board->bitboards.sides[!(SIDE)]; \
+	LegalBoardMoves moves = targets & legal_target_mask(ctx, from); \
+	if (board->opt_pawn != INVALID_PIECE_IDX) { \
+		/* the square the double pushed pawn skipped over */ \
+		u8 ep_target = pawn_push_square[SIDE][board->opt_pawn]; \
+		if ((attacks & idx_to_bitboard(ep_target)) && en_passant_is_legal(board, ctx, from, ep_target)) { \
+			moves |= idx_to_bitboard(ep_target); \
+		} \
+	} \
+	return moves; \
+} \
+\
+/* INVARIANT: a castling right being held implies the king and rook are on their initial squares */ \
+static LegalBoardMoves king_castle_moves_##NAME(ChessBoard * board, const MoveGenContext * ctx, u8 from) { \
+	const BitBoard occupied = board->bitboards.occupied; \
+	LegalBoardMoves moves = 0; \
+	if (ctx->checkers) \
+		return moves; \
+	/* the king may not pass through or land on an attacked square */ \
+	if (board->sides[SIDE].ks_castle_ok \
+		&& !(occupied & between_table[from][KS_ROOK_IDX]) \
+		&& !square_attacked_##NAME(board, from - 1, occupied) \
+		&& !square_attacked_##NAME(board, KS_CASTLE_IDX, occupied)) { \
+		legal_board_moves_add_index(&moves, KS_CASTLE_IDX); \
+	} \
+	if (board->sides[SIDE].qs_castle_ok \
+		&& !(occupied & between_table[from][QS_ROOK_IDX]) \
+		&& !square_attacked_##NAME(board, from + 1, occupied) \
+		&& !square_attacked_##NAME(board, QS_CASTLE_IDX, occupied)) { \
+		legal_board_moves_add_index(&moves, QS_CASTLE_IDX); \
+	} \
+	return moves; \
+} \
+\
+/* king moves without castling, stopping at the first one found when first_only */ \
+static LegalBoardMoves king_step_moves_##NAME(ChessBoard * board, u8 from, bool first_only) { \
+	LegalBoardMoves moves = 0; \
+	/* lift the king so sliders checking it also cover the squares behind it */ \
+	BitBoard occupied = board->bitboards.occupied ^ idx_to_bitboard(from); \
+	BitBoard targets = king_attack_table[from] & ~board->bitboards.sides[SIDE]; \
+	while (targets) { \
+		u8 to = bitboard_pop_lsb(&targets); \
+		if (!square_attacked_##NAME(board, to, occupied)) { \
+			legal_board_moves_add_index(&moves, to); \
+			if (first_only) \
+				break; \
+		} \
+	} \
+	return moves; \
+} \
+\
+static LegalBoardMoves king_moves_##NAME(ChessBoard * board, const MoveGenContext * ctx, u8 from) { \
+	return king_step_moves_##NAME(board, from, false) | king_castle_moves_##NAME(board, ctx, from); \
+} \
+\
+static LegalBoardMoves piece_legal_moves_##NAME(ChessBoard * board, const MoveGenContext * ctx, u8 idx) { \
+	switch (board->slots[idx].piece) { \
+		case CHESS_PAWN: \
+			return pawn_moves_##NAME(board, ctx, idx); \
+		case CHESS_KNIGHT: \
+			return knight_moves(board, ctx, idx); \
+		case CHESS_BISHOP: \
+			return bishop_moves(board, ctx, idx); \
+		case CHESS_ROOK: \
+			return rook_moves(board, ctx, idx); \
+		case CHESS_QUEEN: \
+			return queen_moves(board, ctx, idx); \
+		case CHESS_KING: \
+			return king_moves_##NAME(board, ctx, idx); \
+	} \
+	SDL_assert(false); \
+	return 0; \
+} \
+\
+/* packs the legal targets of the piece on from into list, every promotion piece being its own move */ \
+static void push_piece_moves_##NAME(const ChessBoard * board, MoveList * list, u8 from, LegalBoardMoves moves) { \
+	const BitBoard enemy = board->bitboards.sides[!(SIDE)]; \
+	ChessPiece piece = board->slots[from].piece; \
+	while (moves) { \
+		u8 to = bitboard_pop_lsb(&moves); \
+		u8 flags = (enemy & idx_to_bitboard(to)) ? BOARD_MOVE_CAPTURE : BOARD_MOVE_QUIET; \
+		if (piece == CHESS_PAWN) { \
+			if (pawn_promotion_rank[SIDE] & idx_to_bitboard(to)) { \
+				flags |= BOARD_MOVE_PROMOTION; \
+				move_list_push(list, from, to, flags | (CHESS_KNIGHT - CHESS_KNIGHT)); \
+				move_list_push(list, from, to, flags | (CHESS_BISHOP - CHESS_KNIGHT)); \
+				move_list_push(list, from, to, flags | (CHESS_ROOK - CHESS_KNIGHT)); \
+				move_list_push(list, from, to, flags | (CHESS_QUEEN - CHESS_KNIGHT)); \
+				continue; \
+			} \
+			if (absi((int)from - (int)to) == 16) { \
+				flags = BOARD_MOVE_DOUBLE_PUSH; \
+			} else if (flags == BOARD_MOVE_QUIET && from % 8 != to % 8) { /* diagonal onto an empty square */ \
+				flags = BOARD_MOVE_EN_PASSANT; \
+			} \
+		} else if (piece == CHESS_KING && absi((int)from - (int)to) == 2) { \
+			flags = BOARD_MOVE_CASTLE; \
+		} \
+		move_list_push(list, from, to, flags); \
+	} \
+} \
+\
+static void generate_moves_##NAME(ChessBoard * board, MoveList * list) { \
+	list->count = 0; \
+	MoveGenContext ctx; \
+	movegen_context_init_##NAME(&ctx, board); \
+	const u8 * squares = board->piece_lists[SIDE].squares; \
+	for (u8 i = 0; i < board->piece_lists[SIDE].count; ++i) { \
+		u8 from = squares[i]; \
+		push_piece_moves_##NAME(board, list, from, piece_legal_moves_##NAME(board, &ctx, from)); \
+	} \
+} \
+\
+/* generate_moves_NAME split in two: captures, en passant and promotions when noisy, everything else otherwise */ \
+static void generate_stage_moves_##NAME(ChessBoard * board, MoveList * list, bool noisy) { \
+	const BitBoard enemy = board->bitboards.sides[!(SIDE)]; \
+	list->count = 0; \
+	MoveGenContext ctx; \
+	movegen_context_init_##NAME(&ctx, board); \
+	const u8 * squares = board->piece_lists[SIDE].squares; \
+	for (u8 i = 0; i < board->piece_lists[SIDE].count; ++i) { \
+		u8 from = squares[i]; \
+		BitBoard noisy_targets = enemy; \
+		if (board->slots[from].piece == CHESS_PAWN) { \
+			/* a pawn only leaves its file by capturing */ \
+			noisy_targets |= pawn_attack_table[SIDE][from] | pawn_promotion_rank[SIDE]; \
+		} \
+		LegalBoardMoves moves = piece_legal_moves_##NAME(board, &ctx, from); \
+		moves &= noisy ? noisy_targets : ~noisy_targets; \
+		push_piece_moves_##NAME(board, list, from, moves); \
+	} \
+} \
+\
+/* every move of SIDE following the piece patterns, kings may step into check and pieces leave pins, \
+ * castles only need the right and an empty path, en passant only the target square, \
+ * board_move_is_legal settles the rest \
+ */ \
+static void generate_pseudo_moves_##NAME(ChessBoard * board, MoveList * list) { \
+	const BitBoard own = board->bitboards.sides[SIDE]; \
+	const BitBoard occupied = board->bitboards.occupied; \
+	/* without checkers or pins every target mask lets everything through */ \
+	const MoveGenContext ctx = { \
+		.checkers = 0, \
+		.check_mask = ~(BitBoard)0, \
+		.pinned = 0, \
+		.king_idx = board->sides[SIDE].king_idx, \
+		.side = SIDE, \
+	}; \
+	list->count = 0; \
+	const u8 * squares = board->piece_lists[SIDE].squares; \
+	for (u8 i = 0; i < board->piece_lists[SIDE].count; ++i) { \
+		u8 from = squares[i]; \
+		LegalBoardMoves moves; \
+		if (board->slots[from].piece == CHESS_KING) { \
+			moves = king_attack_table[from] & ~own; \
+			if (board->sides[SIDE].ks_castle_ok && !(occupied & between_table[from][KS_ROOK_IDX])) \
+				legal_board_moves_add_index(&moves, KS_CASTLE_IDX); \
+			if (board->sides[SIDE].qs_castle_ok && !(occupied & between_table[from][QS_ROOK_IDX])) \
+				legal_board_moves_add_index(&moves, QS_CASTLE_IDX); \
+		} else if (board->slots[from].piece == CHESS_PAWN) { \
+			moves = pawn_pseudo_targets(board, SIDE, from); \
+		} else { \
+			moves = piece_legal_moves_##NAME(board, &ctx, from); \
+		} \
+		push_piece_moves_##NAME(board, list, from, moves); \
+	} \
+} \
+\
+/* Castling needs the square next to the king to be free and safe, \
+ * which is already a legal king step, so only steps are tried for the king. \
+ */ \
+static bool has_any_legal_move_##NAME(ChessBoard * board) { \
+	u8 king = board->sides[SIDE].king_idx; \
+	if (king_step_moves_##NAME(board, king, true)) \
+		return true; \
+	MoveGenContext ctx; \
+	movegen_context_init_##NAME(&ctx, board); \
+	if (ctx.check_mask == 0) /* double check */ \
+		return false; \
+	const u8 * squares = board->piece_lists[SIDE].squares; \
+	for (u8 i = 0; i < board->piece_lists[SIDE].count; ++i) { \
+		u8 from = squares[i]; \
+		if (from != king && piece_legal_moves_##NAME(board, &ctx, from)) \
+			return true; \
+	} \
+	return false; \
+} \
+\
+static usize count_leaf_moves_##NAME(ChessBoard * board) { \
+	MoveGenContext ctx; \
+	movegen_context_init_##NAME(&ctx, board); \
+	usize count = 0; \
+	const u8 * squares = board->piece_lists[SIDE].squares; \
+	for (u8 i = 0; i < board->piece_lists[SIDE].count; ++i) { \
+		u8 from = squares[i]; \
+		LegalBoardMoves moves = piece_legal_moves_##NAME(board, &ctx, from); \
+		count += bitboard_count(moves); \
+		if (board->slots[from].piece == CHESS_PAWN) { \
+			/* each promoting target is four moves, one already counted above */ \
+			count += 3 * bitboard_count(moves & pawn_promotion_rank[SIDE]); \
+		} \
+	} \
+	return count; \
+}
+
+DEFINE_SIDE_MOVEGEN(white, WHITE_SIDE,
+	INITIAL_WHITE_KING_SIDE_ROOK_IDX, INITIAL_WHITE_QUEEN_SIDE_ROOK_IDX,
+	WHITE_KING_SIDE_CASTLE_IDX, WHITE_QUEEN_SIDE_CASTLE_IDX)
+DEFINE_SIDE_MOVEGEN(black, BLACK_SIDE,
+	INITIAL_BLACK_KING_SIDE_ROOK_IDX, INITIAL_BLACK_QUEEN_SIDE_ROOK_IDX,
+	BLACK_KING_SIDE_CASTLE_IDX, BLACK_QUEEN_SIDE_CASTLE_IDX)
+
+#undef DEFINE_SIDE_MOVEGEN
+
+static void movegen_context_init(MoveGenContext * ctx, const ChessBoard * board, ChessSide side) {
+	if (side == WHITE_SIDE)
+		movegen_context_init_white(ctx, board);
+	else
+		movegen_context_init_black(ctx, board);
+}
+
+static LegalBoardMoves piece_legal_moves(ChessBoard * board, const MoveGenContext * ctx, u8 idx) {
+	if (ctx->side == WHITE_SIDE)
+		return piece_legal_moves_white(board, ctx, idx);
+	return piece_legal_moves_black(board, ctx, idx);
+}
+
+bool board_square_attacked(const ChessBoard * board, u8 idx, ChessSide by_side) {
+	if (by_side == BLACK_SIDE)
+		return square_attacked_white(board, idx, board->bitboards.occupied);
+	return square_attacked_black(board, idx, board->bitboards.occupied);
 }
 
 bool board_has_checks(ChessBoard * const board, ChessSide const side) {
-	u8 idx = board->sides[side].king_idx;
-	const Vec2i kpos = idx_to_rel_pos(idx, side);
-	for (u8 i = 0; i < 64; ++i) {
-		BoardSlot * slot = &board->slots[i];
-		if (!slot->has_piece)
-			continue;
-		if (slot->side == side)
-			continue;
-		const Vec2i opos = idx_to_rel_pos(i, side);
-		const Vec2i dpos = vec2i_sub(opos, kpos);
-		switch (slot->piece) {
-		case CHESS_PAWN:
-			if (dpos.y == 1 && absi(dpos.x) == 1)
-				return true;
-			goto no_check;
-		case CHESS_KNIGHT: {
-			for (u8 i = 0; i < 8; ++i) {
-				const Vec2i ksquare = vec2i_add(opos, knight_offsets[i]);
-				if (vec2i_equal(ksquare, kpos)) {
-					return true;
-				}
-			}
-			goto no_check;
-		}
-		case CHESS_BISHOP:
-			if (king_in_bishop_LOS(board, &kpos, &dpos, side))
-				return true;
-			goto no_check;
-		case CHESS_ROOK:
-			if (king_in_rook_LOS(board, &kpos, &dpos, side))
-				return true;
-			goto no_check;
-		case CHESS_QUEEN:
-			if (king_in_bishop_LOS(board, &kpos, &dpos, side)
-				|| king_in_rook_LOS(board, &kpos, &dpos, side))
-				return true;
-			goto no_check;
-		case CHESS_KING:
-			if (absi(dpos.x) <= 1 && absi(dpos.y) <= 1)
-				return true;
-			goto no_check;
-		}
-no_check:
-		continue;
+	return board_square_attacked(board, board->sides[side].king_idx, !side);
+}
+
+LegalBoardMoves board_get_legal_moves_for_piece(ChessBoard * board, u8 idx) {
+	SDL_assert(idx != INVALID_PIECE_IDX);
+	BoardSlot * slot = &board->slots[idx];
+	SDL_assert(slot->has_piece == true);
+	MoveGenContext ctx;
+	movegen_context_init(&ctx, board, slot->side);
+	return piece_legal_moves(board, &ctx, idx);
+}
+
+LegalBoardMoves board_get_legal_moves(ChessBoard * board, LegalBoardMoves moves[64]) {
+	LegalBoardMoves composite_moves = 0;
+	SDL_memset(moves, 0, sizeof(*moves) * 64);
+	MoveGenContext ctx;
+	movegen_context_init(&ctx, board, board->side);
+	const u8 * squares = board->piece_lists[board->side].squares;
+	for (u8 i = 0; i < board->piece_lists[board->side].count; ++i) {
+		u8 from = squares[i];
+		moves[from] = piece_legal_moves(board, &ctx, from);
+		composite_moves |= moves[from];
 	}
-	return false;
+	return composite_moves;
 }
 
-static void try_add_move(ChessBoard * board, LegalBoardMoves * moves, u8 from, u8 to, ChessSide side) {
-	BoardMoveResult move = board_make_move_internal(board, from, to);
-	bool king_in_danger = board_has_checks(board, side);
-	board_unmake_move_internal(board, move);
-	if (!king_in_danger) {
-		legal_board_moves_add_index(moves, to);
-	}
-}
-
-LegalBoardMoves pawn_moves(ChessBoard * board, u8 from) {
-	ChessSide side = board->slots[from].side;
-	Vec2i rel_pos = idx_to_rel_pos(from, side);
-	Vec2i fwd_pos = vec2i_new(rel_pos.x, rel_pos.y + 1);
-	LegalBoardMoves moves = 0;
-	if (rel_pos_in_bounds(fwd_pos)) {
-		u8 to = rel_pos_to_idx(fwd_pos, side);
-		if (is_free_idx(board, to)) {
-			try_add_move(board, &moves, from, to, side);
-			if (rel_pos.y == 1) { /* pawn hasn't moved yet */
-				u8 to = rel_pos_to_idx(vec2i_new(rel_pos.x, rel_pos.y + 2), side);
-				if (is_free_idx(board, to)) {
-					try_add_move(board, &moves, from, to, side);
-				}
-			}
-		}
-		if (to % 8 != 0) {
-			u8 ep_idx = rel_pos_to_idx(rel_pos, side) - 1;
-			if (ep_idx == board->opt_pawn || is_enemy_idx(board, to - 1, side)) {
-				try_add_move(board, &moves, from, to - 1, side);
-			}
-		}
-		if (to % 8 != 7) {
-			u8 ep_idx = rel_pos_to_idx(rel_pos, side) + 1;
-			if (ep_idx == board->opt_pawn || is_enemy_idx(board, to + 1, side)) {
-				try_add_move(board, &moves, from, to + 1, side);
-			}
-		}
+BitBoard board_move_touched_squares(const ChessBoard * board, BoardMoveResult result) {
+	BitBoard touched = idx_to_bitboard(result.from) | idx_to_bitboard(result.to) | idx_to_bitboard(result.captured);
+	if (result.castle) {
+		/* the rook jumps from its corner to the square the king crossed */
+		bool king_side = result.to < result.from;
+		touched |= idx_to_bitboard(king_side ? result.to - 1 : result.to + 2);
+		touched |= idx_to_bitboard(king_side ? result.to + 1 : result.to - 1);
+	}
+	/* en passant targets come and go without a piece on them */
+	if (result.last_opt_pawn != INVALID_PIECE_IDX) {
+		touched |= idx_to_bitboard(pawn_push_square[!board->side][result.last_opt_pawn]);
+	}
+	if (board->opt_pawn != INVALID_PIECE_IDX) {
+		touched |= idx_to_bitboard(pawn_push_square[board->side][board->opt_pawn]);
 	}
-	return moves;
+	return touched;
 }
 
-LegalBoardMoves knight_moves(ChessBoard * board, u8 from) {
-	LegalBoardMoves moves = 0;
-	ChessSide side = board->slots[from].side;
-	Vec2i rel_pos = idx_to_rel_pos(from, side);
-	for (int i = 0; i < 8; ++i) {
-		Vec2i new_pos = vec2i_add(rel_pos, knight_offsets[i]);
-		if (!rel_pos_in_bounds(new_pos))
-			continue;
-		u8 to = rel_pos_to_idx(new_pos, side);
-		if (is_free_or_enemy_idx(board, to, side)) {
-			try_add_move(board, &moves, from, to, side);
+LegalBoardMoves board_refresh_legal_moves(ChessBoard * board, LegalBoardMoves moves[64], BitBoard touched) {
+	const ChessSide side = board->side;
+	const u8 king = board->sides[side].king_idx;
+	/* checks and king moves reshape the whole legal set */
+	if ((touched & idx_to_bitboard(king)) || board_has_checks(board, side))
+		return board_get_legal_moves(board, moves);
+	const BitBoard own = board->bitboards.sides[side];
+	const BitBoard occupied = board->bitboards.occupied;
+	BitBoard stale = (touched & own) | idx_to_bitboard(king);
+	while (touched) {
+		u8 idx = bitboard_pop_lsb(&touched);
+		moves[idx] = 0;
+		/* sliders and pins see idx through the first piece on each ray, leapers and pawns by table */
+		BitBoard watchers = bishop_attacks(idx, occupied) | rook_attacks(idx, occupied)
+			| knight_attack_table[idx] | pawn_attack_table[!side][idx];
+		u8 back = pawn_push_square[!side][idx];
+		if (back != INVALID_PIECE_IDX) {
+			watchers |= idx_to_bitboard(back);
+			if (pawn_push_square[!side][back] != INVALID_PIECE_IDX)
+				watchers |= idx_to_bitboard(pawn_push_square[!side][back]);
 		}
+		stale |= watchers & own;
+	}
+	MoveGenContext ctx;
+	movegen_context_init(&ctx, board, side);
+	while (stale) {
+		u8 from = bitboard_pop_lsb(&stale);
+		moves[from] = piece_legal_moves(board, &ctx, from);
 	}
-	return moves;
+	LegalBoardMoves composite_moves = 0;
+	const u8 * squares = board->piece_lists[side].squares;
+	for (u8 i = 0; i < board->piece_lists[side].count; ++i) {
+		composite_moves |= moves[squares[i]];
+	}
+	return composite_moves;
 }
 
-LegalBoardMoves bishop_moves(ChessBoard * board, u8 from) {
-	LegalBoardMoves moves = 0;
-	ChessSide side = board->slots[from].side;
-	Vec2i rel_pos = idx_to_rel_pos(from, side);
-	for (int x = rel_pos.x - 1, y = rel_pos.y - 1; x >= 0 && y >= 0; --x, --y) {
-		u8 to = rel_pos_to_idx(vec2i_new(x, y), side);
-		if (is_free_idx(board, to)) {
-			try_add_move(board, &moves, from, to, side);
-			continue;
-		}
-		if (is_enemy_idx(board, to, side)) {
-			try_add_move(board, &moves, from, to, side);
-		}
-		break;
+/* INVARIANT: from holds the king of the side to move, to is one of its steps or castles */
+static bool king_move_is_legal(ChessBoard * board, u8 from, u8 to) {
+	const ChessSide side = board->side;
+	if (king_attack_table[from] & idx_to_bitboard(to)) {
+		/* lift the king so sliders checking it also cover the squares behind it */
+		BitBoard occupied = board->bitboards.occupied ^ idx_to_bitboard(from);
+		return side == WHITE_SIDE
+			? !square_attacked_white(board, to, occupied)
+			: !square_attacked_black(board, to, occupied);
 	}
-	for (int x = rel_pos.x + 1, y = rel_pos.y - 1; x < 8 && y >= 0; ++x, --y) {
-		u8 to = rel_pos_to_idx(vec2i_new(x, y), side);
-		if (is_free_idx(board, to)) {
-			try_add_move(board, &moves, from, to, side);
-			continue;
-		}
-		if (is_enemy_idx(board, to, side)) {
-			try_add_move(board, &moves, from, to, side);
-		}
-		break;
+	if (absi((int)from - (int)to) == 2) {
+		MoveGenContext ctx;
+		movegen_context_init(&ctx, board, side);
+		LegalBoardMoves castles = side == WHITE_SIDE
+			? king_castle_moves_white(board, &ctx, from)
+			: king_castle_moves_black(board, &ctx, from);
+		return (castles & idx_to_bitboard(to)) != 0;
 	}
-	for (int x = rel_pos.x - 1, y = rel_pos.y + 1; x >= 0 && y < 8; --x, ++y) {
-		u8 to = rel_pos_to_idx(vec2i_new(x, y), side);
-		if (is_free_idx(board, to)) {
-			try_add_move(board, &moves, from, to, side);
-			continue;
-		}
-		if (is_enemy_idx(board, to, side)) {
-			try_add_move(board, &moves, from, to, side);
-		}
+	return false;
+}
+
+/* the king must not be attacked once a non king move is on the board, with the captured piece gone */
+static bool move_keeps_king_safe(const ChessBoard * board, u8 from, u8 to, BitBoard captured) {
+	const ChessSide side = board->side;
+	BitBoard occupied = board->bitboards.occupied;
+	occupied = (occupied ^ idx_to_bitboard(from) ^ (captured & occupied)) | idx_to_bitboard(to);
+	BitBoard enemy = board->bitboards.sides[!side] & ~captured;
+	return (attackers_to(board, board->sides[side].king_idx, occupied) & enemy) == 0;
+}
+
+bool board_is_legal_move(ChessBoard * board, u8 from, u8 to, ChessPiece promo) {
+	const ChessSide side = board->side;
+	if (from >= 64 || to >= 64 || from == to)
+		return false;
+	const BoardSlot * slot = &board->slots[from];
+	const BitBoard own = board->bitboards.sides[side];
+	const BitBoard to_bit = idx_to_bitboard(to);
+	if (!slot->has_piece || slot->side != side || (own & to_bit))
+		return false;
+	BitBoard occupied = board->bitboards.occupied;
+	BitBoard targets = 0;
+	switch (slot->piece) {
+	case CHESS_PAWN:
+		targets = pawn_pseudo_targets(board, side, from);
+		break;
+	case CHESS_KNIGHT:
+		targets = knight_attack_table[from];
 		break;
+	case CHESS_BISHOP:
+		targets = bishop_attacks(from, occupied);
+		break;
+	case CHESS_ROOK:
+		targets = rook_attacks(from, occupied);
+		break;
+	case CHESS_QUEEN:
+		targets = bishop_attacks(from, occupied) | rook_attacks(from, occupied);
+		break;
+	case CHESS_KING:
+		return king_move_is_legal(board, from, to);
 	}
-	for (int x = rel_pos.x + 1, y = rel_pos.y + 1; x < 8 && y < 8; ++x, ++y) {
-		u8 to = rel_pos_to_idx(vec2i_new(x, y), side);
-		if (is_free_idx(board, to)) {
-			try_add_move(board, &moves, from, to, side);
-			continue;
-		}
-		if (is_enemy_idx(board, to, side)) {
-			try_add_move(board, &moves, from, to, side);
+	if (!(targets & to_bit))
+		return false;
+	if (slot->piece == CHESS_PAWN && (pawn_promotion_rank[side] & to_bit)
+		&& (promo < CHESS_KNIGHT || promo > CHESS_QUEEN)) {
+		return false;
+	}
+	BitBoard captured = to_bit;
+	if (slot->piece == CHESS_PAWN && (from % 8) != (to % 8) && !(occupied & to_bit)) {
+		captured = idx_to_bitboard(board->opt_pawn);
+	}
+	return move_keeps_king_safe(board, from, to, captured);
+}
+
+bool board_move_is_legal(ChessBoard * board, BoardMove move) {
+	u8 from = board_move_from(move);
+	u8 to = board_move_to(move);
+	if (board->slots[from].piece == CHESS_KING)
+		return king_move_is_legal(board, from, to);
+	BitBoard captured = board_move_is_en_passant(move) ? idx_to_bitboard(board->opt_pawn) : idx_to_bitboard(to);
+	return move_keeps_king_safe(board, from, to, captured);
+}
+
+bool board_has_any_legal_move(ChessBoard * board) {
+	if (board->side == WHITE_SIDE)
+		return has_any_legal_move_white(board);
+	return has_any_legal_move_black(board);
+}
+
+ChessGameStatus board_game_status(ChessBoard * board) {
+	if (board_has_any_legal_move(board))
+		return CHESS_GAME_ONGOING;
+	return board_has_checks(board, board->side) ? CHESS_GAME_CHECKMATE : CHESS_GAME_STALEMATE;
+}
+
+void board_generate_moves(ChessBoard * board, MoveList * list) {
+	if (board->side == WHITE_SIDE)
+		generate_moves_white(board, list);
+	else
+		generate_moves_black(board, list);
+}
+
+void board_generate_pseudo_moves(ChessBoard * board, MoveList * list) {
+	if (board->side == WHITE_SIDE)
+		generate_pseudo_moves_white(board, list);
+	else
+		generate_pseudo_moves_black(board, list);
+}
+
+void board_generate_noisy_moves(ChessBoard * board, MoveList * list) {
+	if (board->side == WHITE_SIDE)
+		generate_stage_moves_white(board, list, true);
+	else
+		generate_stage_moves_black(board, list, true);
+}
+
+void board_generate_quiet_moves(ChessBoard * board, MoveList * list) {
+	if (board->side == WHITE_SIDE)
+		generate_stage_moves_white(board, list, false);
+	else
+		generate_stage_moves_black(board, list, false);
+}
+
+static const i32 see_piece_value[CHESS_PIECE_COUNT] = {
+	[CHESS_PAWN] = 100,
+	[CHESS_KNIGHT] = 300,
+	[CHESS_BISHOP] = 300,
+	[CHESS_ROOK] = 500,
+	[CHESS_QUEEN] = 900,
+	[CHESS_KING] = 20000,
+};
+
+i32 board_static_exchange(const ChessBoard * board, BoardMove move) {
+	const BitBoard * pieces = board->bitboards.pieces;
+	const BitBoard diagonal = pieces[CHESS_BISHOP] | pieces[CHESS_QUEEN];
+	const BitBoard straight = pieces[CHESS_ROOK] | pieces[CHESS_QUEEN];
+	u8 from = board_move_from(move);
+	u8 to = board_move_to(move);
+	BitBoard occupied = board->bitboards.occupied;
+	i32 gain[32];
+	gain[0] = 0;
+	if (board_move_is_en_passant(move)) {
+		occupied ^= idx_to_bitboard(board->opt_pawn);
+		gain[0] = see_piece_value[CHESS_PAWN];
+	} else if (board->slots[to].has_piece) {
+		gain[0] = see_piece_value[board->slots[to].piece];
+	}
+	ChessPiece attacker = board->slots[from].piece;
+	BitBoard attacker_bit = idx_to_bitboard(from);
+	BitBoard attackers = attackers_to(board, to, occupied);
+	ChessSide side = board->side;
+	u8 depth = 0;
+	/* each side takes back on to with its least valuable attacker, sliders behind the last one joining in */
+	for (;;) {
+		++depth;
+		gain[depth] = see_piece_value[attacker] - gain[depth - 1];
+		if (SDL_max(-gain[depth - 1], gain[depth]) < 0)
+			break;
+		occupied ^= attacker_bit;
+		attackers |= (bishop_attacks(to, occupied) & diagonal) | (rook_attacks(to, occupied) & straight);
+		attackers &= occupied;
+		side = !side;
+		BitBoard own = attackers & board->bitboards.sides[side];
+		if (!own)
+			break;
+		for (attacker = CHESS_PAWN; !(own & pieces[attacker]); ++attacker) {}
+		attacker_bit = own & pieces[attacker] & -(own & pieces[attacker]);
+	}
+	while (--depth) {
+		gain[depth - 1] = -SDL_max(-gain[depth - 1], gain[depth]);
+	}
+	return gain[0];
+}
+
+/* whether move is exactly what board_generate_moves would produce for its squares */
+static bool move_is_generated(ChessBoard * board, BoardMove move) {
+	u8 from = board_move_from(move);
+	u8 to = board_move_to(move);
+	const BoardSlot * slot = &board->slots[from];
+	if (from == to || !slot->has_piece || slot->side != board->side)
+		return false;
+	u8 flags = board->slots[to].has_piece ? BOARD_MOVE_CAPTURE : BOARD_MOVE_QUIET;
+	ChessPiece promo = CHESS_QUEEN;
+	if (slot->piece == CHESS_PAWN) {
+		if (pawn_promotion_rank[board->side] & idx_to_bitboard(to)) {
+			flags |= BOARD_MOVE_PROMOTION | (board_move_flags(move) & 3);
+			promo = board_move_promotion_piece(move);
+		} else if (absi((int)from - (int)to) == 16) {
+			flags = BOARD_MOVE_DOUBLE_PUSH;
+		} else if (flags == BOARD_MOVE_QUIET && from % 8 != to % 8) {
+			flags = BOARD_MOVE_EN_PASSANT;
 		}
-		break;
+	} else if (slot->piece == CHESS_KING && absi((int)from - (int)to) == 2) {
+		flags = BOARD_MOVE_CASTLE;
+	}
+	return flags == board_move_flags(move) && board_is_legal_move(board, from, to, promo);
+}
+
+/* most valuable victim first, then least valuable attacker, promotions ahead by their piece */
+static i32 noisy_move_score(const ChessBoard * board, BoardMove move) {
+	u8 to = board_move_to(move);
+	i32 score = 0;
+	if (board_move_is_promotion(move)) {
+		score += see_piece_value[board_move_promotion_piece(move)] * 16;
+	}
+	if (board_move_is_en_passant(move)) {
+		score += see_piece_value[CHESS_PAWN] * 16;
+	} else if (board->slots[to].has_piece) {
+		score += see_piece_value[board->slots[to].piece] * 16;
 	}
-	return moves;
+	return score - board->slots[board_move_from(move)].piece;
 }
 
-LegalBoardMoves rook_moves(ChessBoard * board, u8 from) {
-	LegalBoardMoves moves = 0;
-	ChessSide side = board->slots[from].side;
-	Vec2i rel_pos = idx_to_rel_pos(from, side);
-	for (int x = rel_pos.x - 1; x >= 0; --x) {
-		u8 to = rel_pos_to_idx(vec2i_new(x, rel_pos.y), side);
-		if (is_free_idx(board, to)) {
-			try_add_move(board, &moves, from, to, side);
+void move_picker_init(MovePicker * picker, ChessBoard * board, BoardMove hash_move, const BoardMove killers[MOVE_PICKER_KILLER_COUNT]) {
+	picker->stage = MOVE_PICKER_HASH;
+	picker->index = 0;
+	picker->bad_captures.count = 0;
+	picker->moves.count = 0;
+	picker->hash_move = move_is_generated(board, hash_move) ? hash_move : BOARD_MOVE_NONE;
+	for (u8 i = 0; i < MOVE_PICKER_KILLER_COUNT; ++i) {
+		picker->killers[i] = BOARD_MOVE_NONE;
+		if (!killers || killers[i] == picker->hash_move || (i > 0 && killers[i] == picker->killers[0]))
 			continue;
+		/* killers are quiet moves from sibling positions, they may not even be legal here */
+		if (!board_move_is_capture(killers[i]) && !board_move_is_promotion(killers[i])
+			&& move_is_generated(board, killers[i])) {
+			picker->killers[i] = killers[i];
 		}
-		if (is_enemy_idx(board, to, side)) {
-			try_add_move(board, &moves, from, to, side);
-		}
-		break;
 	}
-	for (int x = rel_pos.x + 1; x < 8; ++x) {
-		u8 to = rel_pos_to_idx(vec2i_new(x, rel_pos.y), side);
-		if (is_free_idx(board, to)) {
-			try_add_move(board, &moves, from, to, side);
-			continue;
+}
+
+static bool move_picker_is_early(const MovePicker * picker, BoardMove move) {
+	return move == picker->hash_move || move == picker->killers[0] || move == picker->killers[1];
+}
+
+bool move_picker_next(MovePicker * picker, ChessBoard * board, BoardMove * move) {
+	switch (picker->stage) {
+	case MOVE_PICKER_HASH:
+		picker->stage = MOVE_PICKER_GEN_NOISY;
+		if (picker->hash_move != BOARD_MOVE_NONE) {
+			*move = picker->hash_move;
+			return true;
 		}
-		if (is_enemy_idx(board, to, side)) {
-			try_add_move(board, &moves, from, to, side);
+		/* fallthrough */
+	case MOVE_PICKER_GEN_NOISY:
+		board_generate_noisy_moves(board, &picker->moves);
+		for (usize i = 0; i < picker->moves.count; ++i) {
+			picker->scores[i] = noisy_move_score(board, picker->moves.moves[i]);
 		}
-		break;
-	}
-	for (int y = rel_pos.y - 1; y >= 0; --y) {
-		u8 to = rel_pos_to_idx(vec2i_new(rel_pos.x, y), side);
-		if (is_free_idx(board, to)) {
-			try_add_move(board, &moves, from, to, side);
-			continue;
+		picker->index = 0;
+		picker->stage = MOVE_PICKER_GOOD_NOISY;
+		/* fallthrough */
+	case MOVE_PICKER_GOOD_NOISY:
+		while (picker->index < picker->moves.count) {
+			/* selection sort one move at a time, a cutoff usually comes before the list is through */
+			usize best = picker->index;
+			for (usize i = best + 1; i < picker->moves.count; ++i) {
+				if (picker->scores[i] > picker->scores[best])
+					best = i;
+			}
+			BoardMove candidate = picker->moves.moves[best];
+			picker->moves.moves[best] = picker->moves.moves[picker->index];
+			picker->scores[best] = picker->scores[picker->index];
+			++picker->index;
+			if (candidate == picker->hash_move)
+				continue;
+			if (!board_move_is_promotion(candidate) && board_static_exchange(board, candidate) < 0) {
+				picker->bad_captures.moves[picker->bad_captures.count++] = candidate;
+				continue;
+			}
+			*move = candidate;
+			return true;
 		}
-		if (is_enemy_idx(board, to, side)) {
-			try_add_move(board, &moves, from, to, side);
+		picker->index = 0;
+		picker->stage = MOVE_PICKER_KILLERS;
+		/* fallthrough */
+	case MOVE_PICKER_KILLERS:
+		while (picker->index < MOVE_PICKER_KILLER_COUNT) {
+			BoardMove killer = picker->killers[picker->index++];
+			if (killer != BOARD_MOVE_NONE) {
+				*move = killer;
+				return true;
+			}
 		}
-		break;
-	}
-	for (int y = rel_pos.y + 1; y < 8; ++y) {
-		u8 to = rel_pos_to_idx(vec2i_new(rel_pos.x, y), side);
-		if (is_free_idx(board, to)) {
-			try_add_move(board, &moves, from, to, side);
-			continue;
+		picker->stage = MOVE_PICKER_GEN_QUIETS;
+		/* fallthrough */
+	case MOVE_PICKER_GEN_QUIETS:
+		board_generate_quiet_moves(board, &picker->moves);
+		picker->index = 0;
+		picker->stage = MOVE_PICKER_QUIETS;
+		/* fallthrough */
+	case MOVE_PICKER_QUIETS:
+		while (picker->index < picker->moves.count) {
+			BoardMove candidate = picker->moves.moves[picker->index++];
+			if (!move_picker_is_early(picker, candidate)) {
+				*move = candidate;
+				return true;
+			}
 		}
-		if (is_enemy_idx(board, to, side)) {
-			try_add_move(board, &moves, from, to, side);
+		picker->index = 0;
+		picker->stage = MOVE_PICKER_BAD_CAPTURES;
+		/* fallthrough */
+	case MOVE_PICKER_BAD_CAPTURES:
+		if (picker->index < picker->bad_captures.count) {
+			*move = picker->bad_captures.moves[picker->index++];
+			return true;
 		}
+		picker->stage = MOVE_PICKER_DONE;
+		/* fallthrough */
+	case MOVE_PICKER_DONE:
 		break;
 	}
-	return moves;
+	return false;
 }
 
-LegalBoardMoves queen_moves(ChessBoard * board, u8 from) {
-	return bishop_moves(board, from) | rook_moves(board, from);
+static BoardMoveResult board_make_move_packed_internal(ChessBoard * board, BoardMove move) {
+	BoardMoveResult result = board_make_move_internal(board, board_move_from(move), board_move_to(move));
+	if (board_move_is_promotion(move)) {
+		change_piece_type(board, result.to, board_move_promotion_piece(move));
+	}
+	return result;
 }
 
-LegalBoardMoves king_castle_moves(ChessBoard * board, u8 from, ChessSide side) {
-	const u8 initial_ks_rook_idx = side == WHITE_SIDE ? INITIAL_WHITE_KING_SIDE_ROOK_IDX : INITIAL_BLACK_KING_SIDE_ROOK_IDX;
-	const u8 initial_qs_rook_idx = side == WHITE_SIDE ? INITIAL_WHITE_QUEEN_SIDE_ROOK_IDX : INITIAL_BLACK_QUEEN_SIDE_ROOK_IDX;
-	const u8 ks_castle_idx = side == WHITE_SIDE ? WHITE_KING_SIDE_CASTLE_IDX : BLACK_KING_SIDE_CASTLE_IDX;
-	const u8 qs_castle_idx = side == WHITE_SIDE ? WHITE_QUEEN_SIDE_CASTLE_IDX : BLACK_QUEEN_SIDE_CASTLE_IDX;
-	LegalBoardMoves moves = 0;
-	if (board->sides[side].ks_castle_ok
-		&& is_free_idx(board, initial_ks_rook_idx + 1)
-		&& is_free_idx(board, initial_ks_rook_idx + 2)
-		&& !board_has_checks(board, side)) {
-		try_add_move(board, &moves, from, ks_castle_idx, side);
+BoardMoveResult board_make_move_packed(ChessBoard * board, BoardMove move) {
+	BoardMoveResult result = board_make_move(board, board_move_from(move), board_move_to(move));
+	if (board_move_is_promotion(move)) {
+		change_piece_type(board, result.to, board_move_promotion_piece(move));
 	}
-	if (board->sides[side].qs_castle_ok
-		&& is_free_idx(board, initial_qs_rook_idx - 1)
-		&& is_free_idx(board, initial_qs_rook_idx - 2)
-		&& is_free_idx(board, initial_qs_rook_idx - 3)
-		&& !board_has_checks(board, side)) {
-		try_add_move(board, &moves, from, qs_castle_idx, side);
+	return result;
+}
+
+/* Leaf count for depth 1: popcounts of the legal target sets, nothing is made or unmade */
+static usize count_leaf_moves(ChessBoard * board) {
+	if (board->side == WHITE_SIDE)
+		return count_leaf_moves_white(board);
+	return count_leaf_moves_black(board);
+}
+
+usize board_count_moves(ChessBoard * board, usize depth) {
+	if (depth == 0)
+		return 1;
+	if (depth == 1)
+		return count_leaf_moves(board);
+	usize count = 0;
+	MoveList list;
+	board_generate_moves(board, &list);
+	for (usize i = 0; i < list.count; ++i) {
+		BoardMoveResult res = board_make_move_packed_internal(board, list.moves[i]);
+		flip_side(board);
+		count += board_count_moves(board, depth - 1);
+		flip_side(board);
+		board_unmake_move_internal(board, res);
 	}
-	return moves;
+	return count;
 }
 
-LegalBoardMoves king_moves(ChessBoard * board, u8 from) {
-	LegalBoardMoves moves = 0;
-	ChessSide side = board->slots[from].side;
-	Vec2i rel_pos = idx_to_rel_pos(from, side);
-	for (int i = 0; i < 8; ++i) {
-		Vec2i new_pos = vec2i_add(rel_pos, king_offsets[i]);
-		if (!rel_pos_in_bounds(new_pos))
-			continue;
-		u8 to = rel_pos_to_idx(new_pos, side);
-		if (is_free_or_enemy_idx(board, to, side)) {
-			try_add_move(board, &moves, from, to, side);
-		}
+bool perft_cache_init(PerftCache * cache, usize size_mb) {
+	usize bytes = size_mb * 1024 * 1024;
+	usize count = 1;
+	while (count * 2 * sizeof(PerftCacheEntry) <= bytes) {
+		count *= 2;
 	}
-	moves |= king_castle_moves(board, from, side);
-	return moves;
+	cache->entries = SDL_calloc(count, sizeof(PerftCacheEntry));
+	if (!cache->entries) {
+		return false;
+	}
+	cache->mask = count - 1;
+	cache->hits = 0;
+	cache->probes = 0;
+	return true;
 }
 
-LegalBoardMoves board_get_legal_moves_for_piece(ChessBoard * board, u8 idx) {
-	SDL_assert(idx != INVALID_PIECE_IDX);
-	BoardSlot * slot = &board->slots[idx];
-	SDL_assert(slot->has_piece == true);
-	switch (slot->piece) {
-		case CHESS_PAWN:
-			return pawn_moves(board, idx);
-		case CHESS_KNIGHT:
-			return knight_moves(board, idx);
-		case CHESS_BISHOP:
-			return bishop_moves(board, idx);
-		case CHESS_ROOK:
-			return rook_moves(board, idx);
-		case CHESS_QUEEN:
-			return queen_moves(board, idx);
-		case CHESS_KING:
-			return king_moves(board, idx);
+void perft_cache_clear(PerftCache * cache) {
+	SDL_memset(cache->entries, 0, (cache->mask + 1) * sizeof(PerftCacheEntry));
+	cache->hits = 0;
+	cache->probes = 0;
+}
+
+void perft_cache_free(PerftCache * cache) {
+	SDL_free(cache->entries);
+	cache->entries = NULL;
+}
+
+static usize count_moves_hashed(ChessBoard * board, usize depth, PerftCache * cache) {
+	if (depth == 0)
+		return 1;
+	if (depth == 1)
+		return count_leaf_moves(board);
+	u64 key = board->hash;
+	PerftCacheEntry * entry = &cache->entries[key & cache->mask];
+	++cache->probes;
+	if (entry->key == key && entry->depth == depth) {
+		++cache->hits;
+		return entry->count;
 	}
+	usize count = 0;
+	MoveList list;
+	board_generate_moves(board, &list);
+	for (usize i = 0; i < list.count; ++i) {
+		BoardMoveResult res = board_make_move_packed_internal(board, list.moves[i]);
+		flip_side(board);
+		count += count_moves_hashed(board, depth - 1, cache);
+		flip_side(board);
+		board_unmake_move_internal(board, res);
+	}
+	/* always replace, deeper entries are rarer but a perft walk revisits recent ones most */
+	entry->key = key;
+	entry->depth = depth;
+	entry->count = count;
+	return count;
+}
+
+usize board_count_moves_hashed(ChessBoard * board, usize depth, PerftCache * cache) {
+	if (!cache)
+		return board_count_moves(board, depth);
+	return count_moves_hashed(board, depth, cache);
 }
 
 const char * chess_piece_str(ChessPiece piece) {
@@ -676,20 +1564,24 @@ FENParseResult fen_parse_board(const char * iter, ChessBoard * board, const char
 			default:
 				break;
 			white_piece:
+				if (board->piece_lists[WHITE_SIDE].count == CHESS_SIDE_PIECE_LIMIT)
+					return FEN_PARSE_ILLEGAL_STATE;
 				if (piece == CHESS_KING) {
 					board->sides[WHITE_SIDE].king_idx = idx;
 				}
 				--row_budget;
 				--piece_budgets[WHITE_SIDE][piece];
-				board->slots[idx--] = (BoardSlot){ .has_piece = true, .side = WHITE_SIDE, .piece = piece };
+				place_piece(board, idx--, WHITE_SIDE, piece);
 				break;
 			black_piece:
+				if (board->piece_lists[BLACK_SIDE].count == CHESS_SIDE_PIECE_LIMIT)
+					return FEN_PARSE_ILLEGAL_STATE;
 				if (piece == CHESS_KING) {
 					board->sides[BLACK_SIDE].king_idx = idx;
 				}
 				--row_budget;
 				--piece_budgets[BLACK_SIDE][piece];
-				board->slots[idx--] = (BoardSlot){ .has_piece = true, .side = BLACK_SIDE, .piece = piece };
+				place_piece(board, idx--, BLACK_SIDE, piece);
 				break;
 			};
 		}
@@ -740,8 +1632,14 @@ FENParseResult fen_parse_board(const char * iter, ChessBoard * board, const char
 		if (c < '1' || c > '8')
 			return FEN_PARSE_INVALID_INPUT;
 		u8 y = (c - '1');
-		u8 idx = y * 8 + x;
-		board->opt_pawn = idx;
+		/* the FEN names the square behind the pawn, opt_pawn is the pawn itself */
+		if (board->side == WHITE_SIDE && y == 5) {
+			board->opt_pawn = (y - 1) * 8 + x;
+		} else if (board->side == BLACK_SIDE && y == 2) {
+			board->opt_pawn = (y + 1) * 8 + x;
+		} else {
+			return FEN_PARSE_INVALID_INPUT;
+		}
 	} else {
 		board->opt_pawn = INVALID_PIECE_IDX;
 	}
@@ -765,6 +1663,7 @@ FENParseResult fen_parse_board(const char * iter, ChessBoard * board, const char
 	} while (SDL_isdigit(c = *iter));
 	board->half_moves = half_moves;
 	board->full_moves = full_moves;
+	board->hash = board_compute_hash(board);
 	// Validating board now
 	SDL_Log("Validating board");
 	if (board->sides[WHITE_SIDE].king_idx == INVALID_PIECE_IDX
@@ -784,6 +1683,10 @@ FENParseResult fen_parse_board(const char * iter, ChessBoard * board, const char
 		}
 	}
 	SDL_Log("Validated Piece Counts");
+	if (board->bitboards.pieces[CHESS_PAWN] & (pawn_promotion_rank[WHITE_SIDE] | pawn_promotion_rank[BLACK_SIDE])) {
+		return FEN_PARSE_ILLEGAL_STATE;
+	}
+	SDL_Log("Validated pawn ranks");
 	if (mask & 0b0011) {
 		if (board->sides[WHITE_SIDE].king_idx != INITIAL_WHITE_KING_IDX) {
 			return FEN_PARSE_ILLEGAL_STATE;
@@ -815,6 +1718,17 @@ FENParseResult fen_parse_board(const char * iter, ChessBoard * board, const char
 		}
 	}
 	SDL_Log("Validated castling rights");
+	if (board->opt_pawn != INVALID_PIECE_IDX) {
+		/* an enemy pawn that just double pushed, the square it skipped and the one it left both empty */
+		BoardSlot * slot = &board->slots[board->opt_pawn];
+		if (!slot->has_piece || slot->side == board->side || slot->piece != CHESS_PAWN)
+			return FEN_PARSE_ILLEGAL_STATE;
+		u8 skipped = pawn_push_square[board->side][board->opt_pawn];
+		u8 origin = pawn_push_square[board->side][skipped];
+		if (board->bitboards.occupied & (idx_to_bitboard(skipped) | idx_to_bitboard(origin)))
+			return FEN_PARSE_ILLEGAL_STATE;
+	}
+	SDL_Log("Validated en passant square");
 	if (board_has_checks(board, board->side == WHITE_SIDE ? BLACK_SIDE : WHITE_SIDE)) {
 		return FEN_PARSE_ILLEGAL_STATE;
 	}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "chess.h"
+
+/* idx = y * 8 + x with x = 7 - file, so x + 1 heads for the a file and the h file is bit 0 of each rank.
+ * Shifts by +-1, +-7 and +-9 mask with these so nothing wraps around a board edge.
+ */
+#define H_FILE ((BitBoard)0x0101010101010101)
+#define G_FILE ((BitBoard)0x0202020202020202)
+#define B_FILE ((BitBoard)0x4040404040404040)
+#define A_FILE ((BitBoard)0x8080808080808080)
+
+#define NOT_H_FILE (~H_FILE)
+#define NOT_A_FILE (~A_FILE)
+#define NOT_GH_FILES (~(G_FILE | H_FILE))
+#define NOT_AB_FILES (~(A_FILE | B_FILE))
+
+/* positive shifts go up the board, wrap drops what crossed the board edge */
+static BitBoard shift_signed(BitBoard bb, int shift) {
+	return shift > 0 ? bb << shift : bb >> -shift;
+}
+
+static BitBoard shift_step(BitBoard bb, int shift, BitBoard wrap) {
+	return shift_signed(bb, shift) & wrap;
+}
+
+/* sliders spread through empty squares 1, 2 then 4 steps at a time, one last step reaches the blockers */
+static BitBoard slider_fill(BitBoard sliders, BitBoard empty, int shift, BitBoard wrap) {
+	empty &= wrap;
+	sliders |= empty & shift_signed(sliders, shift);
+	empty &= shift_signed(empty, shift);
+	sliders |= empty & shift_signed(sliders, 2 * shift);
+	empty &= shift_signed(empty, 2 * shift);
+	sliders |= empty & shift_signed(sliders, 4 * shift);
+	return shift_step(sliders, shift, wrap);
+}
+
+/* Every square attacked by side: pawn, knight and king patterns plus slider rays up to and including their first blocker.
+ * Sliders are flood filled Kogge-Stone style, three shift and mask steps per direction with no table lookups.
+ * Under CHESS_KERNEL_AVX2 the eight directions run in two four lane vectors, otherwise the plain C fill is used.
+ * -DCHESS_ATTACK_MAP_SSE2 swaps the plain fill for four two lane SSE2 vectors, which pays for bit reversals
+ * and measures slower than plain C in test/misc/attack_map_bench.c.
+ */
+BitBoard board_attack_map(const ChessBoard * board, ChessSide side);
+
+/* The plain C fill, compiled in every build so the vector ones can be checked against it */
+BitBoard board_attack_map_scalar(const ChessBoard * board, ChessSide side);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "chess.h"
+#include "ints.h"
+
+/* two AVX2 vectors of four bitboards */
+#define BOARD_BATCH_SIZE 8
+
+/* Independent positions side by side, lane i of every array belongs to the i-th pushed board.
+ * Lanes are stored from the side to move's point of view, black to move boards mirrored top to bottom,
+ * so own pawns always push up the board and every kernel runs the same steps on all lanes.
+ * Lanes past count hold empty boards, the kernels give them zeroes.
+ * Under CHESS_KERNEL_AVX2 every kernel is built for AVX2, slider fills run four lanes per vector.
+ */
+typedef struct {
+	BitBoard own[BOARD_BATCH_SIZE];
+	BitBoard enemy[BOARD_BATCH_SIZE];
+	BitBoard pieces[CHESS_PIECE_COUNT][BOARD_BATCH_SIZE];
+	BitBoard en_passant[BOARD_BATCH_SIZE]; /* the square an en passant capture lands on, 0 without one */
+	BitBoard castles[BOARD_BATCH_SIZE]; /* king targets of the castling rights still held */
+	ChessSide side[BOARD_BATCH_SIZE];
+	usize count;
+} BoardBatch;
+
+void board_batch_clear(BoardBatch * batch);
+
+/* Copies board into the next free lane, returns false when the batch is full */
+bool board_batch_push(BoardBatch * batch, const ChessBoard * board);
+
+/* Same maps as board_attack_map for both sides of every lane, in the pushed boards' orientation */
+void board_batch_attack_maps(const BoardBatch * batch, BitBoard white[BOARD_BATCH_SIZE], BitBoard black[BOARD_BATCH_SIZE]);
+
+/* Bit i set when the side to move of lane i is in check, as board_has_checks */
+u32 board_batch_checks(const BoardBatch * batch);
+
+/* Legal move counts of every lane, the same as board_count_moves at depth 1.
+ * Sliders, knights and pawns are counted set-wise per direction, a direction's targets never overlap
+ * between pieces of one side. Only en passant captures are tried one by one.
+ */
+void board_batch_count_moves(const BoardBatch * batch, usize counts[BOARD_BATCH_SIZE]);
@@ -43,8 +43,31 @@ typedef struct {
 	u8 last_opt_pawn;
 } BoardMoveResult;
 
+typedef u64 BitBoard;
+
+/* pieces per side, promotions only ever replace a pawn */
+#define CHESS_SIDE_PIECE_LIMIT 16
+
 typedef struct {
 	BoardSlot slots[64];
+	/* mirror of slots, one bit per index, kept in sync on every slot write */
+	struct {
+		BitBoard sides[2];
+		BitBoard pieces[CHESS_PIECE_COUNT];
+		BitBoard occupied;
+	} bitboards;
+	/* squares holding each side's pieces in no particular order,
+	 * piece_list_slot maps an occupied square back to its position in its side's list
+	 */
+	struct {
+		u8 squares[CHESS_SIDE_PIECE_LIMIT];
+		u8 count;
+	} piece_lists[2];
+	u8 piece_list_slot[64];
+	/* Zobrist key of pieces, side to move, castling rights and the en passant file,
+	 * updated by every move and unmove, see board_compute_hash
+	 */
+	u64 hash;
 	usize half_moves;
 	usize full_moves;
 	u8 opt_pawn;
@@ -82,6 +105,36 @@ static const ChessBoard INITIAL_CHESS_BOARD = {
 		B(PAWN), B(PAWN), B(PAWN), B(PAWN), B(PAWN), B(PAWN), B(PAWN), B(PAWN),
 		B(ROOK), B(KNIGHT), B(BISHOP), B(KING), B(QUEEN), B(BISHOP), B(KNIGHT), B(ROOK),
 	},
+	.bitboards = {
+		.sides = {
+			[WHITE_SIDE] = 0x000000000000FFFF,
+			[BLACK_SIDE] = 0xFFFF000000000000,
+		},
+		.pieces = {
+			[CHESS_PAWN] = 0x00FF00000000FF00,
+			[CHESS_KNIGHT] = 0x4200000000000042,
+			[CHESS_BISHOP] = 0x2400000000000024,
+			[CHESS_ROOK] = 0x8100000000000081,
+			[CHESS_QUEEN] = 0x1000000000000010,
+			[CHESS_KING] = 0x0800000000000008,
+		},
+		.occupied = 0xFFFF00000000FFFF,
+	},
+	.piece_lists = {
+		[WHITE_SIDE] = {
+			.squares = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+			.count = 16,
+		},
+		[BLACK_SIDE] = {
+			.squares = { 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63 },
+			.count = 16,
+		},
+	},
+	.piece_list_slot = {
+		0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+		[48] = 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	},
+	.hash = 0, /* keys are offset so the starting position is 0 */
 	.half_moves = 0,
 	.full_moves = 0,
 	.opt_pawn = INVALID_PIECE_IDX,
@@ -145,19 +198,291 @@ static bool legal_board_moves_contains_idx(LegalBoardMoves moves, u8 idx) {
 	return (moves & ((u64)1 << idx)) != 0;
 }
 
+static u8 bitboard_count(BitBoard bb) {
+	return (u8)__builtin_popcountll(bb);
+}
+
+/* INVARIANT: bb != 0 */
+static u8 bitboard_pop_lsb(BitBoard * bb) {
+	u8 idx = (u8)__builtin_ctzll(*bb);
+	*bb &= *bb - 1;
+	return idx;
+}
+
+/* Packed move: bits 0-5 from, bits 6-11 to, bits 12-15 flags.
+ * The low two flag bits hold the promotion piece when BOARD_MOVE_PROMOTION is set,
+ * otherwise they tell apart double pushes, castles and en passant.
+ */
+typedef u16 BoardMove;
+
+#define BOARD_MOVE_QUIET 0x0
+#define BOARD_MOVE_DOUBLE_PUSH 0x1
+#define BOARD_MOVE_CASTLE 0x2
+#define BOARD_MOVE_CAPTURE 0x4
+#define BOARD_MOVE_EN_PASSANT (0x3 | BOARD_MOVE_CAPTURE)
+#define BOARD_MOVE_PROMOTION 0x8
+
+/* from and to are equal, never a real move */
+#define BOARD_MOVE_NONE ((BoardMove)0)
+
+/* the most legal moves any reachable position has is 218 */
+#define MOVE_LIST_CAPACITY 256
+
+typedef struct {
+	BoardMove moves[MOVE_LIST_CAPACITY];
+	usize count;
+} MoveList;
+
+static BoardMove board_move_new(u8 from, u8 to, u8 flags) {
+	return (BoardMove)(from | (to << 6) | (flags << 12));
+}
+
+static u8 board_move_from(BoardMove move) {
+	return move & 63;
+}
+
+static u8 board_move_to(BoardMove move) {
+	return (move >> 6) & 63;
+}
+
+static u8 board_move_flags(BoardMove move) {
+	return move >> 12;
+}
+
+static bool board_move_is_capture(BoardMove move) {
+	return (board_move_flags(move) & BOARD_MOVE_CAPTURE) != 0;
+}
+
+static bool board_move_is_promotion(BoardMove move) {
+	return (board_move_flags(move) & BOARD_MOVE_PROMOTION) != 0;
+}
+
+static bool board_move_is_en_passant(BoardMove move) {
+	return board_move_flags(move) == BOARD_MOVE_EN_PASSANT;
+}
+
+static bool board_move_is_castle(BoardMove move) {
+	return board_move_flags(move) == BOARD_MOVE_CASTLE;
+}
+
+/* INVARIANT: move is a promotion */
+static ChessPiece board_move_promotion_piece(BoardMove move) {
+	return (ChessPiece)(CHESS_KNIGHT + (board_move_flags(move) & 3));
+}
+
+/* Picks the move generation kernel, see ChessKernel, must be called once before any move generation.
+ * No tables are built here, they are static data generated at build time by tools/gen_tables.c.
+ */
+void chess_init(void);
+
+/* Hot move generation and attack kernels, picked once at startup from CPUID by chess_init.
+ * The CHESS_KERNEL environment variable (scalar, bmi2 or avx2) can ask for a lower one to compare them.
+ * Every kernel gives the same results.
+ */
+typedef enum {
+	CHESS_KERNEL_SCALAR, /* magic multiply slider lookups, plain C attack maps */
+	CHESS_KERNEL_BMI2, /* PEXT indexed slider lookups, mailbox builds keep their walk */
+	CHESS_KERNEL_AVX2, /* BMI2 plus four lane attack maps */
+} ChessKernel;
+
+/* x86-64 builds carry the BMI2 and AVX2 kernels, others are always scalar */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CHESS_X86_KERNELS
+#endif
+
+/* the best kernel the CPU runs */
+ChessKernel chess_detect_kernel(void);
+
+/* Switches kernel at runtime, false when the CPU does not run it */
+bool chess_set_kernel(ChessKernel kernel);
+ChessKernel chess_get_kernel(void);
+const char * chess_kernel_str(ChessKernel kernel);
+
+/* Whether any piece of by_side attacks idx on the current board */
+bool board_square_attacked(const ChessBoard * board, u8 idx, ChessSide by_side);
+
 bool board_has_checks(ChessBoard * board, ChessSide side);
 
 /* INVARIANT: from != to */
 BoardMoveResult board_make_move(ChessBoard * board, u8 from, u8 to);
 
+/* INVARIANT: move was generated for the current position */
+BoardMoveResult board_make_move_packed(ChessBoard * board, BoardMove move);
+
+/* Takes back a board_make_move or board_make_move_packed, promotions included.
+ * half_moves is the counter from before the move, which the result cannot restore.
+ * INVARIANT: last_move is the most recent move made on board
+ */
+void board_unmake_move(ChessBoard * board, BoardMoveResult last_move, usize half_moves);
+
+typedef struct {
+	BoardMoveResult result;
+	usize half_moves; /* before the move */
+} BoardHistoryEntry;
+
+/* Growable ring buffer of the moves made on a board, oldest first.
+ * With a limit, pushing onto a full history drops the oldest entry instead of growing.
+ */
+typedef struct {
+	BoardHistoryEntry * entries;
+	usize capacity;
+	usize head; /* slot of the oldest entry */
+	usize count;
+	usize limit; /* 0 for unbounded */
+} BoardHistory;
+
+/* allocates nothing until the first push */
+void board_history_init(BoardHistory * history, usize limit);
+void board_history_clear(BoardHistory * history);
+void board_history_free(BoardHistory * history);
+
+/* returns false when out of memory, the history is left unchanged */
+bool board_history_push(BoardHistory * history, BoardMoveResult result, usize half_moves);
+
+/* removes the newest entry into out, returns false when empty */
+bool board_history_pop(BoardHistory * history, BoardHistoryEntry * out);
+
+/* i counts from the oldest entry still held */
+const BoardHistoryEntry * board_history_get(const BoardHistory * history, usize i);
+
+/* board_make_move that also records the move, returns false when out of memory without moving */
+bool board_history_make_move(BoardHistory * history, ChessBoard * board, u8 from, u8 to, BoardMoveResult * result);
+
+/* pops the newest move and takes it back on board, returns false when the history is empty */
+bool board_history_undo(BoardHistory * history, ChessBoard * board);
+
 usize board_count_moves(ChessBoard * board, usize depth);
 
-void board_set_promotion_type(ChessBoard * board, ChessPiece piece);
+/* Zobrist key of the pieces, side to move, castle rights and en passant file,
+ * computed from scratch, board->hash is the incrementally kept copy
+ */
+u64 board_compute_hash(const ChessBoard * board);
+
+typedef struct {
+	u64 key;
+	u64 count : 56;
+	u64 depth : 8;
+} PerftCacheEntry;
+
+typedef struct {
+	PerftCacheEntry * entries;
+	usize mask; /* entry count - 1, the count is a power of two */
+	usize hits;
+	usize probes;
+} PerftCache;
+
+/* sizes the cache to the largest power of two entry count fitting in size_mb */
+bool perft_cache_init(PerftCache * cache, usize size_mb);
+void perft_cache_clear(PerftCache * cache);
+void perft_cache_free(PerftCache * cache);
+
+/* Same result as board_count_moves, reusing transposed subtrees.
+ * A NULL cache falls back to the uncached walk.
+ */
+usize board_count_moves_hashed(ChessBoard * board, usize depth, PerftCache * cache);
+
+/* Fills list with every legal move of the side to move,
+ * each promotion piece being its own move
+ */
+void board_generate_moves(ChessBoard * board, MoveList * list);
+
+/* Fills list like board_generate_moves without checking that the king is safe afterwards,
+ * a search then only pays board_move_is_legal for the moves it gets to play.
+ * Only meant for staged and lazy validation: a plain alpha-beta over every move measures
+ * no faster than the legal generator (test/misc/search_bench.c), pins and checks being cheap there.
+ * Perft and the GUI stay on the legal generators.
+ */
+void board_generate_pseudo_moves(ChessBoard * board, MoveList * list);
+
+/* INVARIANT: move comes from board_generate_pseudo_moves for the current position */
+bool board_move_is_legal(ChessBoard * board, BoardMove move);
+
+/* board_generate_moves split in two, noisy moves are captures, en passant and every promotion */
+void board_generate_noisy_moves(ChessBoard * board, MoveList * list);
+void board_generate_quiet_moves(ChessBoard * board, MoveList * list);
+
+/* Material the side to move wins by playing move and trading off on its target square,
+ * in centipawns with the king worth 20000. Pins are ignored.
+ */
+i32 board_static_exchange(const ChessBoard * board, BoardMove move);
+
+typedef enum {
+	MOVE_PICKER_HASH,
+	MOVE_PICKER_GEN_NOISY,
+	MOVE_PICKER_GOOD_NOISY,
+	MOVE_PICKER_KILLERS,
+	MOVE_PICKER_GEN_QUIETS,
+	MOVE_PICKER_QUIETS,
+	MOVE_PICKER_BAD_CAPTURES,
+	MOVE_PICKER_DONE,
+} MovePickerStage;
+
+#define MOVE_PICKER_KILLER_COUNT 2
+
+/* Hands out the legal moves of a position one stage at a time: the hash move, captures and promotions
+ * that do not lose material by board_static_exchange, the killers, the quiet moves and last the losing captures.
+ * Quiet moves are only generated once the earlier stages ran out.
+ */
+typedef struct {
+	MoveList moves; /* the noisy moves, then the quiet ones */
+	MoveList bad_captures;
+	i32 scores[MOVE_LIST_CAPACITY];
+	usize index;
+	BoardMove hash_move;
+	BoardMove killers[MOVE_PICKER_KILLER_COUNT];
+	MovePickerStage stage;
+} MovePicker;
+
+/* hash_move and killers that are not legal in board are dropped, killers may be NULL */
+void move_picker_init(MovePicker * picker, ChessBoard * board, BoardMove hash_move, const BoardMove killers[MOVE_PICKER_KILLER_COUNT]);
+
+/* INVARIANT: board is the position picker was initialized with */
+bool move_picker_next(MovePicker * picker, ChessBoard * board, BoardMove * move);
+
+/* INVARIANT: idx holds the pawn that was just promoted by board_make_move */
+void board_set_promotion_type(ChessBoard * board, u8 idx, ChessPiece piece);
+
+/* For building boards piece by piece, keeps bitboards, piece lists and king indexes in sync,
+ * set board->hash = board_compute_hash(board) once every field is filled in.
+ * INVARIANT: idx is empty
+ */
+void board_place_piece(ChessBoard * board, u8 idx, ChessSide side, ChessPiece piece);
 
 /* INVARIANT: Index must be to actual piece */
 /* INVARIANT: Kings should never be capturable or corruption of state occurs */
 LegalBoardMoves board_get_legal_moves_for_piece(ChessBoard * board, u8 idx);
 
+/* Fills moves for every piece of the side to move, returns their union */
+LegalBoardMoves board_get_legal_moves(ChessBoard * board, LegalBoardMoves moves[64]);
+
+/* Squares whose contents changed with a move made on board: from, to, the captured piece,
+ * the castling rook's two squares and the en passant targets that appeared or expired.
+ */
+BitBoard board_move_touched_squares(const ChessBoard * board, BoardMoveResult result);
+
+/* Like board_get_legal_moves, but only recomputes the pieces that the touched squares can affect.
+ * Falls back to a full refresh when the side to move is in check or its king is on a touched square.
+ * INVARIANT: moves were filled for board->side out of check, touched holds every square changed since
+ */
+LegalBoardMoves board_refresh_legal_moves(ChessBoard * board, LegalBoardMoves moves[64], BitBoard touched);
+
+/* Checks one move of the side to move without generating the others.
+ * promo is only looked at when a pawn reaches the last rank, and must then be a knight, bishop, rook or queen.
+ */
+bool board_is_legal_move(ChessBoard * board, u8 from, u8 to, ChessPiece promo);
+
+/* Whether the side to move has a legal move, trying the king first and stopping at the first one */
+bool board_has_any_legal_move(ChessBoard * board);
+
+typedef enum {
+	CHESS_GAME_ONGOING,
+	CHESS_GAME_CHECKMATE,
+	CHESS_GAME_STALEMATE,
+} ChessGameStatus;
+
+/* checkmate or stalemate for the side to move, other draws aren't detected */
+ChessGameStatus board_game_status(ChessBoard * board);
+
 const char * chess_piece_str(ChessPiece piece);
 
 typedef enum {
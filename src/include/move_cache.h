@@ -0,0 +1,51 @@
+#pragma once
+
+#include "chess.h"
+#include "ints.h"
+
+#define MOVE_CACHE_WAYS 4
+
+/* The legal moves of one position, only the squares of the side to move are kept */
+typedef struct {
+	u64 key;
+	LegalBoardMoves moves[CHESS_SIDE_PIECE_LIMIT];
+	u8 squares[CHESS_SIDE_PIECE_LIMIT];
+	u8 count;
+	bool used : 1;
+	bool referenced : 1; /* second chance bit of the clock */
+} MoveCacheEntry;
+
+typedef struct {
+	MoveCacheEntry ways[MOVE_CACHE_WAYS];
+	u8 hand;
+} MoveCacheBucket;
+
+/* Legal move tables keyed by ChessBoard.hash, for positions that come back when replaying or scrubbing games.
+ * Each hash picks a bucket of MOVE_CACHE_WAYS entries evicted by clock (second chance) replacement.
+ */
+typedef struct {
+	MoveCacheBucket * buckets;
+	usize mask; /* bucket count - 1, the count is a power of two */
+	usize hits;
+	usize misses;
+	usize evictions;
+} MoveCache;
+
+/* sizes the cache to the largest power of two bucket count fitting in size_kb */
+bool move_cache_init(MoveCache * cache, usize size_kb);
+void move_cache_clear(MoveCache * cache);
+void move_cache_free(MoveCache * cache);
+
+/* Fills moves like board_get_legal_moves when the position is cached, returns false on a miss */
+bool move_cache_probe(MoveCache * cache, const ChessBoard * board, LegalBoardMoves moves[64]);
+
+/* INVARIANT: moves are the legal moves of board, as filled by board_get_legal_moves */
+void move_cache_store(MoveCache * cache, const ChessBoard * board, const LegalBoardMoves moves[64]);
+
+/* Same result as board_get_legal_moves, reusing cached positions and storing new ones.
+ * A NULL cache falls back to the uncached generation.
+ */
+LegalBoardMoves board_get_legal_moves_cached(ChessBoard * board, LegalBoardMoves moves[64], MoveCache * cache);
+
+/* Logs the hit rate and evictions so far, prefixed by name */
+void move_cache_log_stats(const MoveCache * cache, const char * name);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "chess.h"
+#include "ints.h"
+
+typedef struct {
+	usize nodes; /* leaf nodes counted by this thread */
+	usize tasks; /* subtrees taken from its own queue */
+	usize stolen; /* subtrees taken from another thread's queue */
+} PerftThreadStats;
+
+/* Splits the tree split_depth plies below the root into subtrees,
+ * deals them out to thread_count workers, each with a queue other idle workers steal from.
+ * A thread_count of 0 uses every logical core.
+ * worker_count, when not NULL, receives the number of workers that ran, 1 when the count stayed serial.
+ * stats, when not NULL, receives one entry per worker in its first stats_capacity entries,
+ * workers past stats_capacity are left out and entries past the worker count zeroed.
+ * Returns the same count as board_count_moves.
+ */
+usize board_count_moves_parallel(ChessBoard * board, usize depth, usize thread_count, usize split_depth,
+	PerftThreadStats * stats, usize stats_capacity, usize * worker_count);
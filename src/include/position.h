@@ -0,0 +1,54 @@
+#pragma once
+
+#include "chess.h"
+#include "ints.h"
+
+/* castle right bits of CompactPosition.flags, bit 0 is the side to move */
+#define POSITION_BLACK_TO_MOVE 0x01
+#define POSITION_WHITE_KS_CASTLE 0x02
+#define POSITION_WHITE_QS_CASTLE 0x04
+#define POSITION_BLACK_KS_CASTLE 0x08
+#define POSITION_BLACK_QS_CASTLE 0x10
+
+/* A 40 byte ChessBoard for copy-make, a search keeps a stack of these instead of unmaking.
+ * squares holds a nibble per index, the low nibble for the even one:
+ * 0 for an empty square, otherwise the piece + 1 with bit 3 set for black.
+ * Move counters saturate at 65535.
+ */
+typedef struct {
+	u8 squares[32];
+	u16 half_moves;
+	u16 full_moves;
+	u8 opt_pawn;
+	u8 flags;
+	u8 king_idx[2];
+} CompactPosition;
+
+#define POSITION_EMPTY_NIBBLE 0
+
+static u8 position_nibble(const CompactPosition * pos, u8 idx) {
+	return (pos->squares[idx >> 1] >> ((idx & 1) << 2)) & 0xF;
+}
+
+static void position_set_nibble(CompactPosition * pos, u8 idx, u8 nibble) {
+	u8 shift = (idx & 1) << 2;
+	pos->squares[idx >> 1] = (pos->squares[idx >> 1] & ~(0xF << shift)) | (nibble << shift);
+}
+
+static u8 position_piece_nibble(ChessSide side, ChessPiece piece) {
+	return (piece + 1) | (side << 3);
+}
+
+static ChessSide position_side_to_move(const CompactPosition * pos) {
+	return (pos->flags & POSITION_BLACK_TO_MOVE) ? BLACK_SIDE : WHITE_SIDE;
+}
+
+CompactPosition position_from_board(const ChessBoard * board);
+
+/* Rebuilds every ChessBoard field, bitboards, piece lists and hash included */
+void position_to_board(const CompactPosition * pos, ChessBoard * board);
+
+/* Copy-make: the position after move, which must be legal in pos,
+ * with the same side, castling, en passant and counter updates as board_make_move_packed.
+ */
+CompactPosition position_apply(const CompactPosition * pos, BoardMove move);
@@ -1,6 +1,7 @@
 #include "maths.h"
 #include "texture.h"
 #include "chess.h"
+#include "move_cache.h"
 #include "uci.h"
 
 typedef struct State State;
@@ -125,10 +126,14 @@ typedef enum {
 } GameState;
 
 #define PIECE_ANIMATION_SPAN 0.1
+#define STATE_MOVE_CACHE_KB 1024
 
 struct State {
 	struct {
-		LegalBoardMoves legal_moves[64];
+		/* kept per side so each refresh only redoes what the squares touched since its last turn affect */
+		LegalBoardMoves legal_moves[2][64];
+		BitBoard touched[2];
+		MoveCache move_cache;
 		ChessBoard board;
 		Player p1;
 		Player p2;
@@ -0,0 +1,101 @@
+#include "include/move_cache.h"
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_stdinc.h>
+
+bool move_cache_init(MoveCache * cache, usize size_kb) {
+	usize bytes = size_kb * 1024;
+	usize count = 1;
+	while (count * 2 * sizeof(MoveCacheBucket) <= bytes) {
+		count *= 2;
+	}
+	cache->buckets = SDL_calloc(count, sizeof(MoveCacheBucket));
+	if (!cache->buckets) {
+		return false;
+	}
+	cache->mask = count - 1;
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->evictions = 0;
+	return true;
+}
+
+void move_cache_clear(MoveCache * cache) {
+	SDL_memset(cache->buckets, 0, (cache->mask + 1) * sizeof(MoveCacheBucket));
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->evictions = 0;
+}
+
+void move_cache_free(MoveCache * cache) {
+	SDL_free(cache->buckets);
+	cache->buckets = NULL;
+}
+
+static MoveCacheBucket * move_cache_bucket(MoveCache * cache, u64 key) {
+	return &cache->buckets[key & cache->mask];
+}
+
+bool move_cache_probe(MoveCache * cache, const ChessBoard * board, LegalBoardMoves moves[64]) {
+	MoveCacheBucket * bucket = move_cache_bucket(cache, board->hash);
+	for (u8 i = 0; i < MOVE_CACHE_WAYS; ++i) {
+		MoveCacheEntry * entry = &bucket->ways[i];
+		if (!entry->used || entry->key != board->hash)
+			continue;
+		SDL_memset(moves, 0, sizeof(*moves) * 64);
+		for (u8 j = 0; j < entry->count; ++j) {
+			moves[entry->squares[j]] = entry->moves[j];
+		}
+		entry->referenced = true;
+		++cache->hits;
+		return true;
+	}
+	++cache->misses;
+	return false;
+}
+
+void move_cache_store(MoveCache * cache, const ChessBoard * board, const LegalBoardMoves moves[64]) {
+	MoveCacheBucket * bucket = move_cache_bucket(cache, board->hash);
+	/* sweep the hand past recently probed entries, clearing their bit, until an unused or unreferenced one */
+	MoveCacheEntry * entry;
+	for (;;) {
+		entry = &bucket->ways[bucket->hand];
+		bucket->hand = (bucket->hand + 1) % MOVE_CACHE_WAYS;
+		if (!entry->used || !entry->referenced)
+			break;
+		entry->referenced = false;
+	}
+	if (entry->used) {
+		++cache->evictions;
+	}
+	const u8 * squares = board->piece_lists[board->side].squares;
+	entry->key = board->hash;
+	entry->count = board->piece_lists[board->side].count;
+	for (u8 i = 0; i < entry->count; ++i) {
+		entry->squares[i] = squares[i];
+		entry->moves[i] = moves[squares[i]];
+	}
+	entry->used = true;
+	entry->referenced = false;
+}
+
+LegalBoardMoves board_get_legal_moves_cached(ChessBoard * board, LegalBoardMoves moves[64], MoveCache * cache) {
+	if (!cache)
+		return board_get_legal_moves(board, moves);
+	if (move_cache_probe(cache, board, moves)) {
+		LegalBoardMoves composite_moves = 0;
+		for (u8 i = 0; i < 64; ++i) {
+			composite_moves |= moves[i];
+		}
+		return composite_moves;
+	}
+	LegalBoardMoves composite_moves = board_get_legal_moves(board, moves);
+	move_cache_store(cache, board, moves);
+	return composite_moves;
+}
+
+void move_cache_log_stats(const MoveCache * cache, const char * name) {
+	usize probes = cache->hits + cache->misses;
+	SDL_Log("%s: %zu hits, %zu misses (%.1f%% hit rate), %zu evictions over %zu entries",
+		name, cache->hits, cache->misses, probes ? 100.0 * (double)cache->hits / (double)probes : 0.0,
+		cache->evictions, (cache->mask + 1) * MOVE_CACHE_WAYS);
+}
@@ -0,0 +1,173 @@
+#include "include/perft.h"
+#include "include/position.h"
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_thread.h>
+#include <SDL3/SDL_atomic.h>
+#include <SDL3/SDL_cpuinfo.h>
+
+typedef struct PerftWorker PerftWorker;
+
+typedef struct {
+	CompactPosition * tasks; /* a ChessBoard is several times larger, tasks are expanded by the worker that runs them */
+	PerftWorker * workers;
+	usize worker_count;
+	usize depth; /* plies left below each task */
+} PerftJob;
+
+struct PerftWorker {
+	PerftJob * job;
+	SDL_Thread * thread;
+	SDL_AtomicInt next; /* owner and thieves both claim tasks by bumping this */
+	int end;
+	usize index;
+	PerftThreadStats stats;
+};
+
+typedef struct {
+	CompactPosition * items;
+	usize count;
+	usize capacity;
+} PerftTaskList;
+
+/* task indices are claimed through an SDL_AtomicInt, so a list never grows past SDL_MAX_SINT32 */
+static bool task_list_push(PerftTaskList * list, const ChessBoard * board) {
+	if (list->count == list->capacity) {
+		if (list->capacity >= SDL_MAX_SINT32)
+			return false;
+		usize capacity = list->capacity ? list->capacity * 2 : 256;
+		if (capacity > SDL_MAX_SINT32)
+			capacity = SDL_MAX_SINT32;
+		CompactPosition * items = SDL_realloc(list->items, capacity * sizeof(*items));
+		if (!items)
+			return false;
+		list->items = items;
+		list->capacity = capacity;
+	}
+	list->items[list->count++] = position_from_board(board);
+	return true;
+}
+
+/* returns false when out of memory or out of task indices */
+static bool collect_tasks(ChessBoard * board, usize plies, PerftTaskList * tasks) {
+	if (plies == 0)
+		return task_list_push(tasks, board);
+	MoveList list;
+	board_generate_moves(board, &list);
+	for (usize i = 0; i < list.count; ++i) {
+		ChessBoard child = *board;
+		board_make_move_packed(&child, list.moves[i]);
+		if (!collect_tasks(&child, plies - 1, tasks))
+			return false;
+	}
+	return true;
+}
+
+static bool take_task(PerftWorker * queue, usize * task) {
+	if (SDL_GetAtomicInt(&queue->next) >= queue->end)
+		return false;
+	int i = SDL_AddAtomicInt(&queue->next, 1);
+	if (i >= queue->end)
+		return false;
+	*task = (usize)i;
+	return true;
+}
+
+static int perft_worker_main(void * data) {
+	PerftWorker * worker = data;
+	PerftJob * job = worker->job;
+	for (;;) {
+		usize task;
+		if (take_task(worker, &task)) {
+			++worker->stats.tasks;
+		} else {
+			bool stole = false;
+			for (usize i = 1; i < job->worker_count && !stole; ++i) {
+				PerftWorker * victim = &job->workers[(worker->index + i) % job->worker_count];
+				stole = take_task(victim, &task);
+			}
+			if (!stole)
+				return 0;
+			++worker->stats.stolen;
+		}
+		ChessBoard board;
+		position_to_board(&job->tasks[task], &board);
+		worker->stats.nodes += board_count_moves(&board, job->depth);
+	}
+}
+
+static usize count_moves_serial(ChessBoard * board, usize depth, PerftThreadStats * stats, usize stats_capacity, usize * worker_count) {
+	usize count = board_count_moves(board, depth);
+	if (stats && stats_capacity) {
+		SDL_memset(stats, 0, sizeof(*stats) * stats_capacity);
+		stats[0].nodes = count;
+		stats[0].tasks = 1;
+	}
+	if (worker_count) {
+		*worker_count = 1;
+	}
+	return count;
+}
+
+usize board_count_moves_parallel(ChessBoard * board, usize depth, usize thread_count, usize split_depth,
+		PerftThreadStats * stats, usize stats_capacity, usize * worker_count) {
+	if (thread_count == 0) {
+		thread_count = (usize)SDL_GetNumLogicalCPUCores();
+	}
+	if (split_depth == 0) {
+		split_depth = 1;
+	}
+	if (thread_count <= 1 || depth <= split_depth) {
+		return count_moves_serial(board, depth, stats, stats_capacity, worker_count);
+	}
+	PerftTaskList tasks = { .items = NULL, .count = 0, .capacity = 0 };
+	while (!collect_tasks(board, split_depth, &tasks)) {
+		/* out of task indices rather than memory, split shallower */
+		if (tasks.capacity < SDL_MAX_SINT32 || split_depth == 1) {
+			SDL_free(tasks.items);
+			return count_moves_serial(board, depth, stats, stats_capacity, worker_count);
+		}
+		--split_depth;
+		tasks.count = 0;
+	}
+	PerftWorker * workers = SDL_calloc(thread_count, sizeof(*workers));
+	if (!workers) {
+		SDL_free(tasks.items);
+		return count_moves_serial(board, depth, stats, stats_capacity, worker_count);
+	}
+	const usize task_count = tasks.count;
+	PerftJob job = {
+		.tasks = tasks.items,
+		.workers = workers,
+		.worker_count = thread_count,
+		.depth = depth - split_depth,
+	};
+	/* contiguous slices keep sibling subtrees together, stealing evens out the rest */
+	for (usize i = 0; i < thread_count; ++i) {
+		workers[i].job = &job;
+		workers[i].index = i;
+		SDL_SetAtomicInt(&workers[i].next, (int)(task_count * i / thread_count));
+		workers[i].end = (int)(task_count * (i + 1) / thread_count);
+	}
+	/* the calling thread works as worker 0, a worker that fails to start simply gets robbed */
+	for (usize i = 1; i < thread_count; ++i) {
+		workers[i].thread = SDL_CreateThread(perft_worker_main, "perft", &workers[i]);
+	}
+	perft_worker_main(&workers[0]);
+	usize count = 0;
+	for (usize i = 0; i < thread_count; ++i) {
+		SDL_WaitThread(workers[i].thread, NULL);
+		count += workers[i].stats.nodes;
+		if (stats && i < stats_capacity) {
+			stats[i] = workers[i].stats;
+		}
+	}
+	if (stats && stats_capacity > thread_count) {
+		SDL_memset(stats + thread_count, 0, sizeof(*stats) * (stats_capacity - thread_count));
+	}
+	if (worker_count) {
+		*worker_count = thread_count;
+	}
+	SDL_free(workers);
+	SDL_free(tasks.items);
+	return count;
+}
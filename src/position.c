@@ -0,0 +1,100 @@
+#include "include/position.h"
+#include <SDL3/SDL_assert.h>
+#include <SDL3/SDL_stdinc.h>
+
+/* castle rights lost when a move starts or ends on a king or rook home square */
+static const u8 castle_rights_lost[64] = {
+	[INITIAL_WHITE_KING_SIDE_ROOK_IDX] = POSITION_WHITE_KS_CASTLE,
+	[INITIAL_WHITE_KING_IDX] = POSITION_WHITE_KS_CASTLE | POSITION_WHITE_QS_CASTLE,
+	[INITIAL_WHITE_QUEEN_SIDE_ROOK_IDX] = POSITION_WHITE_QS_CASTLE,
+	[INITIAL_BLACK_KING_SIDE_ROOK_IDX] = POSITION_BLACK_KS_CASTLE,
+	[INITIAL_BLACK_KING_IDX] = POSITION_BLACK_KS_CASTLE | POSITION_BLACK_QS_CASTLE,
+	[INITIAL_BLACK_QUEEN_SIDE_ROOK_IDX] = POSITION_BLACK_QS_CASTLE,
+};
+
+static u16 saturate_u16(usize value) {
+	return value > 0xFFFF ? 0xFFFF : (u16)value;
+}
+
+CompactPosition position_from_board(const ChessBoard * board) {
+	CompactPosition pos;
+	SDL_zero(pos);
+	for (u8 idx = 0; idx < 64; ++idx) {
+		const BoardSlot * slot = &board->slots[idx];
+		if (slot->has_piece) {
+			position_set_nibble(&pos, idx, position_piece_nibble(slot->side, slot->piece));
+		}
+	}
+	pos.half_moves = saturate_u16(board->half_moves);
+	pos.full_moves = saturate_u16(board->full_moves);
+	pos.opt_pawn = board->opt_pawn;
+	if (board->side == BLACK_SIDE)
+		pos.flags |= POSITION_BLACK_TO_MOVE;
+	if (board->sides[WHITE_SIDE].ks_castle_ok)
+		pos.flags |= POSITION_WHITE_KS_CASTLE;
+	if (board->sides[WHITE_SIDE].qs_castle_ok)
+		pos.flags |= POSITION_WHITE_QS_CASTLE;
+	if (board->sides[BLACK_SIDE].ks_castle_ok)
+		pos.flags |= POSITION_BLACK_KS_CASTLE;
+	if (board->sides[BLACK_SIDE].qs_castle_ok)
+		pos.flags |= POSITION_BLACK_QS_CASTLE;
+	pos.king_idx[WHITE_SIDE] = board->sides[WHITE_SIDE].king_idx;
+	pos.king_idx[BLACK_SIDE] = board->sides[BLACK_SIDE].king_idx;
+	return pos;
+}
+
+void position_to_board(const CompactPosition * pos, ChessBoard * board) {
+	SDL_zerop(board);
+	for (u8 idx = 0; idx < 64; ++idx) {
+		u8 nibble = position_nibble(pos, idx);
+		if (nibble != POSITION_EMPTY_NIBBLE) {
+			board_place_piece(board, idx, (nibble >> 3) & 1, (nibble & 7) - 1);
+		}
+	}
+	board->half_moves = pos->half_moves;
+	board->full_moves = pos->full_moves;
+	board->opt_pawn = pos->opt_pawn;
+	board->side = position_side_to_move(pos);
+	board->sides[WHITE_SIDE].ks_castle_ok = (pos->flags & POSITION_WHITE_KS_CASTLE) != 0;
+	board->sides[WHITE_SIDE].qs_castle_ok = (pos->flags & POSITION_WHITE_QS_CASTLE) != 0;
+	board->sides[BLACK_SIDE].ks_castle_ok = (pos->flags & POSITION_BLACK_KS_CASTLE) != 0;
+	board->sides[BLACK_SIDE].qs_castle_ok = (pos->flags & POSITION_BLACK_QS_CASTLE) != 0;
+	board->sides[WHITE_SIDE].king_idx = pos->king_idx[WHITE_SIDE];
+	board->sides[BLACK_SIDE].king_idx = pos->king_idx[BLACK_SIDE];
+	board->hash = board_compute_hash(board);
+}
+
+CompactPosition position_apply(const CompactPosition * pos, BoardMove move) {
+	CompactPosition next = *pos;
+	const ChessSide side = position_side_to_move(pos);
+	const u8 from = board_move_from(move);
+	const u8 to = board_move_to(move);
+	u8 nibble = position_nibble(pos, from);
+	SDL_assert(nibble != POSITION_EMPTY_NIBBLE);
+	bool pawn = (nibble & 7) == CHESS_PAWN + 1;
+	bool capture = board_move_is_capture(move);
+	position_set_nibble(&next, from, POSITION_EMPTY_NIBBLE);
+	if (board_move_is_en_passant(move)) {
+		/* the captured pawn is one step behind the target, seen from the mover */
+		position_set_nibble(&next, side == WHITE_SIDE ? to - 8 : to + 8, POSITION_EMPTY_NIBBLE);
+	} else if (board_move_is_castle(move)) {
+		/* the king side rook is 3 files right of the king, the queen side one 4 files left */
+		u8 rook_from = to < from ? from - 3 : from + 4;
+		u8 rook_to = to < from ? to + 1 : to - 1;
+		position_set_nibble(&next, rook_to, position_nibble(pos, rook_from));
+		position_set_nibble(&next, rook_from, POSITION_EMPTY_NIBBLE);
+	}
+	if (board_move_is_promotion(move)) {
+		nibble = position_piece_nibble(side, board_move_promotion_piece(move));
+	} else if ((nibble & 7) == CHESS_KING + 1) {
+		next.king_idx[side] = to;
+	}
+	position_set_nibble(&next, to, nibble);
+	next.flags &= ~(castle_rights_lost[from] | castle_rights_lost[to]);
+	next.opt_pawn = board_move_flags(move) == BOARD_MOVE_DOUBLE_PUSH ? to : INVALID_PIECE_IDX;
+	next.half_moves = capture || pawn ? 0 : saturate_u16((usize)pos->half_moves + 1);
+	if (side == BLACK_SIDE)
+		next.full_moves = saturate_u16((usize)pos->full_moves + 1);
+	next.flags ^= POSITION_BLACK_TO_MOVE;
+	return next;
+}
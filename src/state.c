@@ -56,18 +56,18 @@ static inline Rect2f get_slot_rect(int slot) {
 	return rect2f_new(SLOT_X, SLOT_HEIGHT * slot, SLOT_WIDTH, SLOT_HEIGHT);
 }
 
-static LegalBoardMoves refresh_moves(ChessBoard * board, LegalBoardMoves moves[64]) {
-	LegalBoardMoves composite_moves = 0;
-	SDL_memset(moves, 0, sizeof(*moves) * 64);
-	for (u8 i = 0; i < 64; ++i) {
-		BoardSlot * slot = &board->slots[i];
-		if (slot->has_piece && slot->side == board->side) {
-			LegalBoardMoves _moves = board_get_legal_moves_for_piece(board, i);
-			moves[i] = _moves;
-			composite_moves |= _moves;
+static void refresh_moves(State * state) {
+	ChessBoard * board = &state->game.board;
+	ChessSide side = board->side;
+	MoveCache * cache = &state->game.move_cache;
+	if (!cache->buckets || !move_cache_probe(cache, board, state->game.legal_moves[side])) {
+		board_refresh_legal_moves(board, state->game.legal_moves[side], state->game.touched[side]);
+		if (cache->buckets) {
+			move_cache_store(cache, board, state->game.legal_moves[side]);
 		}
 	}
-	return composite_moves;
+	/* moves found in check are cut down to the evasions, the next refresh must start over */
+	state->game.touched[side] = board_has_checks(board, side) ? ~(BitBoard)0 : 0;
 }
 
 void state_init(State * state) {
@@ -126,6 +126,10 @@ static void state_stage_cleanup(State * state) {
 		case STATE_STAGE_GAME:
 			player_free(&state->game.p1);
 			player_free(&state->game.p2);
+			if (state->game.move_cache.buckets) {
+				move_cache_log_stats(&state->game.move_cache, "Legal move cache");
+				move_cache_free(&state->game.move_cache);
+			}
 			break;
 		case STATE_STAGE_TITLE:
 		case STATE_STAGE_ABOUT:
@@ -145,7 +149,12 @@ static void state_start_game(State * state) {
 	state->game.board = INITIAL_CHESS_BOARD;
 	FENParseResult parsed = fen_parse_board("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 0", &state->game.board, NULL);
 	SDL_assert(parsed == FEN_PARSE_OK);
-	refresh_moves(&state->game.board, state->game.legal_moves);
+	if (!move_cache_init(&state->game.move_cache, STATE_MOVE_CACHE_KB)) {
+		SDL_Log("Legal move cache disabled, out of memory");
+	}
+	state->game.touched[WHITE_SIDE] = ~(BitBoard)0;
+	state->game.touched[BLACK_SIDE] = ~(BitBoard)0;
+	refresh_moves(state);
 	if (slider_status(&state->board_rotate_slider)) {
 		state->game.view = WHITE_SIDE;
 	} else {
@@ -233,11 +242,12 @@ static Player * state_current_player(State * state) {
 }
 
 void state_game_next_turn(State * state) {
-	LegalBoardMoves comp = refresh_moves(&state->game.board, state->game.legal_moves);
-	if (comp == 0) {
+	if (board_game_status(&state->game.board) != CHESS_GAME_ONGOING) {
+		SDL_zero(state->game.legal_moves);
 		state->game.state = GAME_STATE_FINISHED;
 		return;
 	}
+	refresh_moves(state);
 	if (slider_status(&state->board_rotate_slider)) {
 		state->game.view ^= 1;
 	}
@@ -247,6 +257,9 @@ void state_game_next_turn(State * state) {
 void state_game_make_move(State * state, u8 from, u8 to) {
 	Player * p = state_current_player(state);
 	BoardMoveResult result = board_make_move(&state->game.board, from, to);
+	BitBoard touched = board_move_touched_squares(&state->game.board, result);
+	state->game.touched[WHITE_SIDE] |= touched;
+	state->game.touched[BLACK_SIDE] |= touched;
 	if (result.promotion) {
 		u8 piece = player_request_promotion(state, p, to);
 		if (piece == PROMOTION_REQUEST_ERROR) {
@@ -256,7 +269,7 @@ void state_game_make_move(State * state, u8 from, u8 to) {
 		if (piece == PROMOTION_REQUEST_PENDING) {
 			return;
 		}
-		state->game.board.slots[to].piece = piece; // TODO: validate?
+		board_set_promotion_type(&state->game.board, to, piece); // TODO: validate?
 	}
 	state_game_next_turn(state);
 }
@@ -326,7 +339,7 @@ static StateUpdateResult state_process_mouse_press(State * state, f32 elapsed_ti
 				return STATE_UPDATE_CONTINUE;
 			}
 			state->game.promotion_dialog = false;
-			state->game.board.slots[state->game.promotion_idx].piece = piece; // TODO: validate?
+			board_set_promotion_type(&state->game.board, state->game.promotion_idx, piece); // TODO: validate?
 			state_game_next_turn(state);
 			return STATE_UPDATE_CONTINUE;
 		}
@@ -471,7 +484,7 @@ void state_update_game(State * state, f32 elapsed_time) {
 				state_show_err_msg(state, S("Client Disconnect"));
 				break;
 			case PLAYER_POLL_MOVED: {
-				LegalBoardMoves moves = state->game.legal_moves[poll.as.moved.from];
+				LegalBoardMoves moves = state->game.legal_moves[state->game.board.side][poll.as.moved.from];
 				if (!legal_board_moves_contains_idx(moves, poll.as.moved.to)) {
 					if (p->type == PLAYER_BOT) {
 						SDL_Log("Invalid move %u, %u", poll.as.moved.from, poll.as.moved.to);
@@ -492,7 +505,7 @@ void state_update_game(State * state, f32 elapsed_time) {
 				break;
 			}
 			case PLAYER_POLL_PROMOTION:
-				state->game.board.slots[poll.as.promo.to].piece = poll.as.promo.piece; // TODO, validate?
+				board_set_promotion_type(&state->game.board, poll.as.promo.to, poll.as.promo.piece); // TODO, validate?
 				state_game_next_turn(state);
 				break;
 		}
@@ -793,7 +806,7 @@ void state_draw_game(State * state, TextureCache * cache, Display * display) {
 	bool playing_animation = state->game.state == GAME_STATE_MOVING;
 	if (p_has_piece) {
 		Texture * tx = texture_cache_lookup(cache, TEXTURE_ID_HOVER_SHADOW);
-		LegalBoardMoves moves = state->game.legal_moves[p->as.human.held_idx];
+		LegalBoardMoves moves = state->game.legal_moves[state->game.board.side][p->as.human.held_idx];
 		for (int y = 0; y < 8; ++y) {
 			for (int x = 0; x < 8; ++x) {
 				u8 sx = (u8)x;
@@ -0,0 +1,41 @@
+#include "../src/include/chess.h"
+#include "../src/include/attack_map.h"
+#include "test.h"
+
+/* compares both attack maps of both sides with board_square_attacked square by square, counting wrong maps */
+static usize check_attack_maps(const TestWalkNode * node, void * data) {
+	(void)data;
+	ChessBoard * board = node->board;
+	usize mismatches = 0;
+	for (ChessSide side = WHITE_SIDE; side <= BLACK_SIDE; ++side) {
+		BitBoard expected = 0;
+		for (u8 idx = 0; idx < 64; ++idx) {
+			if (board_square_attacked(board, idx, side))
+				expected |= (BitBoard)1 << idx;
+		}
+		if (board_attack_map(board, side) != expected)
+			++mismatches;
+		if (board_attack_map_scalar(board, side) != expected)
+			++mismatches;
+	}
+	return mismatches;
+}
+
+void test_attack_map(void) {
+	const char * positions[] = {
+		perft_positions[PERFT_INITIAL].fen,
+		perft_positions[PERFT_KIWIPETE].fen,
+		perft_positions[PERFT_POSITION_3].fen,
+		perft_positions[PERFT_POSITION_4].fen,
+		"Q6Q/8/8/2k5/8/8/8/Q2K3Q w - - 0 1",
+	};
+	for (u8 i = 0; i < SDL_arraysize(positions); ++i) {
+		ChessBoard board;
+		if (fen_parse_board(positions[i], &board, NULL) != FEN_PARSE_OK) {
+			ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", positions[i]);
+			continue;
+		}
+		usize mismatches = test_walk(&board, 2, check_attack_maps, NULL);
+		ASSERT(mismatches == 0, "Attack maps from [%s] differed from board_square_attacked %"SDL_PRIu64" times", positions[i], mismatches);
+	}
+}
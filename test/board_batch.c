@@ -0,0 +1,74 @@
+#include "../src/include/chess.h"
+#include "../src/include/attack_map.h"
+#include "../src/include/board_batch.h"
+#include "test.h"
+
+typedef struct {
+	BoardBatch batch;
+	ChessBoard boards[BOARD_BATCH_SIZE];
+	usize positions;
+	usize mismatches;
+} BatchCheck;
+
+/* runs every kernel on the filled lanes and compares them with the single board functions */
+static void batch_check_flush(BatchCheck * check) {
+	usize counts[BOARD_BATCH_SIZE];
+	BitBoard white[BOARD_BATCH_SIZE], black[BOARD_BATCH_SIZE];
+	board_batch_count_moves(&check->batch, counts);
+	board_batch_attack_maps(&check->batch, white, black);
+	u32 checks = board_batch_checks(&check->batch);
+	for (usize i = 0; i < check->batch.count; ++i) {
+		ChessBoard * board = &check->boards[i];
+		bool in_check = (checks >> i) & 1;
+		if (counts[i] != board_count_moves(board, 1)
+			|| in_check != board_has_checks(board, board->side)
+			|| white[i] != board_attack_map(board, WHITE_SIDE)
+			|| black[i] != board_attack_map(board, BLACK_SIDE))
+			++check->mismatches;
+	}
+	for (usize i = check->batch.count; i < BOARD_BATCH_SIZE; ++i) {
+		if (counts[i] || white[i] || black[i] || ((checks >> i) & 1))
+			++check->mismatches;
+	}
+	check->positions += check->batch.count;
+	board_batch_clear(&check->batch);
+}
+
+/* queues the position into the next lane, mismatches are counted in BatchCheck when the lanes run */
+static usize batch_check_push(const TestWalkNode * node, void * data) {
+	BatchCheck * check = data;
+	check->boards[check->batch.count] = *node->board;
+	board_batch_push(&check->batch, node->board);
+	if (check->batch.count == BOARD_BATCH_SIZE)
+		batch_check_flush(check);
+	return 0;
+}
+
+void test_board_batch(void) {
+	const char * positions[] = {
+		perft_positions[PERFT_INITIAL].fen,
+		perft_positions[PERFT_KIWIPETE].fen,
+		perft_positions[PERFT_POSITION_3].fen,
+		/* position 4 mirrored, black to move */
+		"r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+		perft_positions[PERFT_POSITION_5].fen,
+		"8/8/8/K1pP3r/8/8/8/7k w - c6 0 2",
+	};
+	ChessKernel selected = chess_get_kernel();
+	for (ChessKernel kernel = CHESS_KERNEL_SCALAR; kernel <= chess_detect_kernel(); ++kernel) {
+		chess_set_kernel(kernel);
+		for (u8 i = 0; i < SDL_arraysize(positions); ++i) {
+			ChessBoard board;
+			if (fen_parse_board(positions[i], &board, NULL) != FEN_PARSE_OK) {
+				ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", positions[i]);
+				continue;
+			}
+			BatchCheck check = {0};
+			test_walk(&board, 2, batch_check_push, &check);
+			batch_check_flush(&check);
+			ASSERT(check.mismatches == 0, "Batch kernels under %s differed on %"SDL_PRIu64" of %"SDL_PRIu64" positions from [%s]",
+				chess_kernel_str(kernel), check.mismatches, check.positions, positions[i]);
+		}
+	}
+	chess_set_kernel(selected);
+}
@@ -1,4 +1,5 @@
 #include "../src/include/chess.h"
+#include "../src/include/perft.h"
 #include "test.h"
 
 void test_move_counts(void) {
@@ -22,7 +23,7 @@ void test_move_counts(void) {
 		}
 	}
 
-	const char * position = "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8";
+	const char * position = perft_positions[PERFT_POSITION_5].fen;
 	FENParseResult parse = fen_parse_board(position, &board, NULL);
 	if (parse != FEN_PARSE_OK) {
 		ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", position);
@@ -46,3 +47,250 @@ void test_move_counts(void) {
 		}
 	}
 }
+
+void test_hashed_move_counts(void) {
+	PerftCache cache;
+	OOM_CHECK(perft_cache_init(&cache, 16));
+	ChessBoard board = INITIAL_CHESS_BOARD;
+	usize expected = board_count_moves(&board, 4);
+	usize count = board_count_moves_hashed(&board, 5, &cache);
+	ASSERT(count == 4865609, "Hashed move count at depth [5] is %"SDL_PRIu64", expected 4865609", count);
+	ASSERT(cache.hits != 0, "Hashed move count reused %"SDL_PRIu64" of %"SDL_PRIu64" probes", cache.hits, cache.probes);
+	count = board_count_moves_hashed(&board, 4, &cache);
+	ASSERT(count == expected, "Hashed move count reusing a warm cache is %"SDL_PRIu64", expected %"SDL_PRIu64, count, expected);
+	count = board_count_moves_hashed(&board, 4, NULL);
+	ASSERT(count == expected, "Hashed move count without a cache is %"SDL_PRIu64", expected %"SDL_PRIu64, count, expected);
+	const char * position = perft_positions[PERFT_KIWIPETE].fen;
+	if (fen_parse_board(position, &board, NULL) != FEN_PARSE_OK) {
+		ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", position);
+	} else {
+		perft_cache_clear(&cache);
+		count = board_count_moves_hashed(&board, 4, &cache);
+		ASSERT(count == 4085603, "Hashed move count for [%s] at depth [4] is %"SDL_PRIu64", expected 4085603", position, count);
+	}
+	perft_cache_free(&cache);
+}
+
+void test_parallel_move_counts(void) {
+	PerftThreadStats stats[4];
+	ChessBoard board = INITIAL_CHESS_BOARD;
+	for (usize split = 1; split <= 2; ++split) {
+		usize workers = 0;
+		usize count = board_count_moves_parallel(&board, 5, 4, split, stats, SDL_arraysize(stats), &workers);
+		ASSERT(count == 4865609, "Parallel move count split at [%"SDL_PRIu64"] is %"SDL_PRIu64", expected 4865609", split, count);
+		ASSERT(workers == 4, "Parallel move count ran %"SDL_PRIu64" workers, expected 4", workers);
+		usize nodes = 0;
+		for (u8 i = 0; i < 4; ++i) {
+			LOG("Thread [%u]: %"SDL_PRIu64" nodes, %"SDL_PRIu64" tasks, %"SDL_PRIu64" stolen",
+				i, stats[i].nodes, stats[i].tasks, stats[i].stolen);
+			nodes += stats[i].nodes;
+		}
+		ASSERT(nodes == count, "Per thread node counts add up to %"SDL_PRIu64, nodes);
+	}
+	/* more workers than the buffer holds, writes stop at its capacity */
+	PerftThreadStats guarded[3] = {0};
+	usize workers = 0;
+	usize count = board_count_moves_parallel(&board, 4, 4, 1, guarded, 2, &workers);
+	ASSERT(count == 197281 && workers == 4, "Parallel move count into a short buffer is %"SDL_PRIu64" on %"SDL_PRIu64" workers, expected 197281 on 4",
+		count, workers);
+	ASSERT(guarded[2].nodes == 0 && guarded[2].tasks == 0 && guarded[2].stolen == 0,
+		"Stats past the given capacity must be left alone");
+	/* a thread_count of 0 reports how many cores it took */
+	usize cores = (usize)SDL_max(SDL_GetNumLogicalCPUCores(), 1);
+	count = board_count_moves_parallel(&board, 4, 0, 1, NULL, 0, &workers);
+	ASSERT(count == 197281 && workers == cores, "Parallel move count on every core is %"SDL_PRIu64" on %"SDL_PRIu64" workers, expected 197281 on %"SDL_PRIu64,
+		count, workers, cores);
+}
+
+static usize check_hash(const TestWalkNode * node, void * data) {
+	(void)data;
+	return node->board->hash != board_compute_hash(node->board);
+}
+
+/* every list entry must point back at itself and cover exactly its side's bitboard */
+static bool piece_lists_consistent(const ChessBoard * board) {
+	for (u8 side = 0; side < 2; ++side) {
+		BitBoard seen = 0;
+		for (u8 i = 0; i < board->piece_lists[side].count; ++i) {
+			u8 idx = board->piece_lists[side].squares[i];
+			if (board->piece_list_slot[idx] != i)
+				return false;
+			seen |= (BitBoard)1 << idx;
+		}
+		if (seen != board->bitboards.sides[side])
+			return false;
+	}
+	return true;
+}
+
+static usize check_piece_lists(const TestWalkNode * node, void * data) {
+	(void)data;
+	return !piece_lists_consistent(node->board);
+}
+
+void test_piece_lists(void) {
+	ChessBoard board = INITIAL_CHESS_BOARD;
+	ASSERT(piece_lists_consistent(&board), "Initial board piece lists must match its bitboards");
+	const char * positions[] = {
+		perft_positions[PERFT_KIWIPETE].fen,
+		perft_positions[PERFT_POSITION_4].fen,
+	};
+	for (u8 i = 0; i < SDL_arraysize(positions); ++i) {
+		if (fen_parse_board(positions[i], &board, NULL) != FEN_PARSE_OK) {
+			ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", positions[i]);
+			continue;
+		}
+		usize mismatches = test_walk(&board, 3, check_piece_lists, NULL);
+		ASSERT(mismatches == 0, "Piece lists for [%s] diverged from the bitboards at %"SDL_PRIu64" nodes", positions[i], mismatches);
+	}
+	ASSERT(fen_parse_board("QQQQQQQQ/QQQQQQQQ/Q7/8/8/8/8/K6k w - - 0 1", &board, NULL) == FEN_PARSE_ILLEGAL_STATE,
+		"More than sixteen pieces of one side must be illegal state");
+}
+
+void test_zobrist_hash(void) {
+	ChessBoard board = INITIAL_CHESS_BOARD;
+	ASSERT(board.hash == board_compute_hash(&board), "Initial board hash must match a full recompute");
+	/* g1f3 g8f6 b1c3 and b1c3 g8f6 g1f3 transpose into the same position */
+	ChessBoard a = board;
+	board_make_move(&a, 1, 18);
+	board_make_move(&a, 57, 42);
+	board_make_move(&a, 6, 21);
+	ChessBoard b = board;
+	board_make_move(&b, 6, 21);
+	board_make_move(&b, 57, 42);
+	board_make_move(&b, 1, 18);
+	ASSERT(a.hash == b.hash, "Transposed move orders must hash equally");
+	ASSERT(a.hash != board.hash, "Different positions must hash differently");
+	const char * position = perft_positions[PERFT_KIWIPETE].fen;
+	if (fen_parse_board(position, &board, NULL) != FEN_PARSE_OK) {
+		ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", position);
+	} else {
+		usize mismatches = test_walk(&board, 3, check_hash, NULL);
+		ASSERT(mismatches == 0, "Incremental hash diverged from a full recompute at %"SDL_PRIu64" nodes", mismatches);
+	}
+	const char * en_passant = "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1";
+	if (fen_parse_board(en_passant, &board, NULL) != FEN_PARSE_OK) {
+		ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", en_passant);
+	} else {
+		usize count = board_count_moves(&board, 6);
+		ASSERT(count == 1440467, "Move count for [%s] at depth [6] is %"SDL_PRIu64", expected 1440467", en_passant, count);
+	}
+}
+
+static int compare_moves(const void * a, const void * b) {
+	return (int)*(const BoardMove *)a - (int)*(const BoardMove *)b;
+}
+
+#define STAGED_MAX_DEPTH 8
+
+/* perft through MovePicker, counting nodes where it handed out a different move set than board_generate_moves.
+ * Hash moves alternate between a real move and the parent's move, killers come from the last sibling,
+ * so both often do not fit the position.
+ */
+static usize count_moves_staged(ChessBoard * board, usize depth, BoardMove parent,
+		BoardMove killers[STAGED_MAX_DEPTH][MOVE_PICKER_KILLER_COUNT], usize * mismatches) {
+	if (depth == 0)
+		return 1;
+	MoveList expected;
+	board_generate_moves(board, &expected);
+	BoardMove hash_move = (depth & 1) && expected.count ? expected.moves[expected.count / 2] : parent;
+	MovePicker picker;
+	move_picker_init(&picker, board, hash_move, killers[depth]);
+	MoveList picked = { .count = 0 };
+	BoardMove move;
+	usize count = 0;
+	while (picked.count < MOVE_LIST_CAPACITY && move_picker_next(&picker, board, &move)) {
+		picked.moves[picked.count++] = move;
+		ChessBoard next = *board;
+		board_make_move_packed(&next, move);
+		count += count_moves_staged(&next, depth - 1, move, killers, mismatches);
+		if (!board_move_is_capture(move) && !board_move_is_promotion(move)) {
+			killers[depth][1] = killers[depth][0];
+			killers[depth][0] = move;
+		}
+	}
+	SDL_qsort(expected.moves, expected.count, sizeof(BoardMove), compare_moves);
+	SDL_qsort(picked.moves, picked.count, sizeof(BoardMove), compare_moves);
+	if (picked.count != expected.count
+		|| SDL_memcmp(picked.moves, expected.moves, expected.count * sizeof(BoardMove)) != 0)
+		++*mismatches;
+	return count;
+}
+
+void test_staged_move_counts(void) {
+	for (u8 i = 0; i < PERFT_POSITION_COUNT; ++i) {
+		ChessBoard board;
+		if (fen_parse_board(perft_positions[i].fen, &board, NULL) != FEN_PARSE_OK) {
+			ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", perft_positions[i].fen);
+			continue;
+		}
+		BoardMove killers[STAGED_MAX_DEPTH][MOVE_PICKER_KILLER_COUNT] = {0};
+		usize mismatches = 0;
+		usize count = count_moves_staged(&board, perft_positions[i].depth, BOARD_MOVE_NONE, killers, &mismatches);
+		ASSERT(count == perft_positions[i].count && mismatches == 0,
+			"Staged move count for [%s] at depth [%"SDL_PRIu64"] is %"SDL_PRIu64", expected %"SDL_PRIu64", %"SDL_PRIu64" nodes picked a different move set",
+			perft_positions[i].fen, perft_positions[i].depth, count, perft_positions[i].count, mismatches);
+	}
+
+	const struct {
+		const char * fen;
+		u8 from;
+		u8 to;
+		i32 value;
+	} exchanges[] = {
+		{ "4k3/8/8/3p4/4P3/8/8/4K3 w - - 0 1", 27, 36, 100 }, /* free pawn */
+		{ "4k3/8/2p5/3p4/4P3/8/8/4K3 w - - 0 1", 27, 36, 0 }, /* pawn for pawn */
+		{ "4k3/8/2p5/3p4/8/8/3Q4/4K3 w - - 0 1", 12, 36, -800 }, /* queen for pawn */
+		{ "4k3/3r4/8/3p4/8/8/3R4/3RK3 w - - 0 1", 12, 36, 100 }, /* the second rook backs up the first */
+	};
+	for (u8 i = 0; i < SDL_arraysize(exchanges); ++i) {
+		ChessBoard board;
+		if (fen_parse_board(exchanges[i].fen, &board, NULL) != FEN_PARSE_OK) {
+			ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", exchanges[i].fen);
+			continue;
+		}
+		i32 value = board_static_exchange(&board, board_move_new(exchanges[i].from, exchanges[i].to, BOARD_MOVE_CAPTURE));
+		ASSERT(value == exchanges[i].value, "Static exchange in [%s] is %d, expected %d", exchanges[i].fen, value, exchanges[i].value);
+	}
+}
+
+/* perft over pseudo-legal moves filtered by board_move_is_legal, counting nodes whose filtered set differs from the legal one */
+static usize count_moves_pseudo(ChessBoard * board, usize depth, usize * mismatches) {
+	if (depth == 0)
+		return 1;
+	MoveList expected;
+	MoveList pseudo;
+	MoveList legal = { .count = 0 };
+	board_generate_moves(board, &expected);
+	board_generate_pseudo_moves(board, &pseudo);
+	usize count = 0;
+	for (usize i = 0; i < pseudo.count; ++i) {
+		if (!board_move_is_legal(board, pseudo.moves[i]))
+			continue;
+		legal.moves[legal.count++] = pseudo.moves[i];
+		ChessBoard next = *board;
+		board_make_move_packed(&next, pseudo.moves[i]);
+		count += count_moves_pseudo(&next, depth - 1, mismatches);
+	}
+	SDL_qsort(expected.moves, expected.count, sizeof(BoardMove), compare_moves);
+	SDL_qsort(legal.moves, legal.count, sizeof(BoardMove), compare_moves);
+	if (legal.count != expected.count
+		|| SDL_memcmp(legal.moves, expected.moves, expected.count * sizeof(BoardMove)) != 0)
+		++*mismatches;
+	return count;
+}
+
+void test_pseudo_legal_move_counts(void) {
+	for (u8 i = 0; i < PERFT_POSITION_COUNT; ++i) {
+		ChessBoard board;
+		if (fen_parse_board(perft_positions[i].fen, &board, NULL) != FEN_PARSE_OK) {
+			ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", perft_positions[i].fen);
+			continue;
+		}
+		usize mismatches = 0;
+		usize count = count_moves_pseudo(&board, perft_positions[i].depth, &mismatches);
+		ASSERT(count == perft_positions[i].count && mismatches == 0,
+			"Pseudo-legal move count for [%s] at depth [%"SDL_PRIu64"] is %"SDL_PRIu64", expected %"SDL_PRIu64", %"SDL_PRIu64" nodes filtered to a different move set",
+			perft_positions[i].fen, perft_positions[i].depth, count, perft_positions[i].count, mismatches);
+	}
+}
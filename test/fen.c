@@ -17,6 +17,14 @@ if ((test)->c != (expected)->c) { \
 	ASSERT_EQ(full_moves);
 	ASSERT_EQ(half_moves);
 	ASSERT_EQ(opt_pawn);
+	for (u8 i = 0; i < 2; ++i) {
+		ASSERT_EQ(bitboards.sides[i]);
+	}
+	for (u8 i = 0; i < CHESS_PIECE_COUNT; ++i) {
+		ASSERT_EQ(bitboards.pieces[i]);
+	}
+	ASSERT_EQ(bitboards.occupied);
+	ASSERT_EQ(hash);
 	for (u8 i = 0; i < 64; ++i) {
 		if (!test->slots[i].has_piece) {
 			ASSERT_EQ(slots[i].has_piece);
@@ -45,4 +53,27 @@ void test_fen_parse_and_encode(void) {
 	OOM_CHECK(str_builder_ensure_null_term(&builder));
 	ASSERT(SDL_strcmp(initial_fen, builder.data) == 0, "Initial board converted to FEN string must equal initial FEN string");
 	str_builder_free(&builder);
+	const char * en_passant_fen = "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1";
+	ASSERT(fen_parse_board(en_passant_fen, &board, NULL) == FEN_PARSE_OK,
+		"FEN string with an en passant square must be ok");
+	ASSERT(board.opt_pawn == 28, "En passant square d3 must point at the pawn on d4, found %u", board.opt_pawn);
+	builder = str_builder_new();
+	OOM_CHECK(fen_encode_board(&builder, &board));
+	OOM_CHECK(str_builder_ensure_null_term(&builder));
+	ASSERT(SDL_strcmp(en_passant_fen, builder.data) == 0, "En passant board converted to FEN string must equal its FEN string");
+	str_builder_free(&builder);
+	ASSERT(fen_parse_board("8/8/1k6/2b5/2pP4/8/5K2/8 b - d6 0 1", &board, NULL) == FEN_PARSE_INVALID_INPUT,
+		"En passant square on the wrong rank must be invalid input");
+	ASSERT(fen_parse_board("4k3/8/8/3PN3/8/8/8/4K3 w - e6 0 1", &board, NULL) == FEN_PARSE_ILLEGAL_STATE,
+		"En passant square behind a knight must be illegal state");
+	ASSERT(fen_parse_board("4k3/8/8/3P4/8/8/8/4K3 w - e6 0 1", &board, NULL) == FEN_PARSE_ILLEGAL_STATE,
+		"En passant square without a pawn must be illegal state");
+	ASSERT(fen_parse_board("4k3/8/8/3PP3/8/8/8/4K3 w - e6 0 1", &board, NULL) == FEN_PARSE_ILLEGAL_STATE,
+		"En passant square behind an own pawn must be illegal state");
+	ASSERT(fen_parse_board("4k3/8/4n3/3Pp3/8/8/8/4K3 w - e6 0 1", &board, NULL) == FEN_PARSE_ILLEGAL_STATE,
+		"En passant square with a piece on it must be illegal state");
+	ASSERT(fen_parse_board("4k3/4n3/8/3Pp3/8/8/8/4K3 w - e6 0 1", &board, NULL) == FEN_PARSE_ILLEGAL_STATE,
+		"En passant pawn with a piece on its start square must be illegal state");
+	ASSERT(fen_parse_board("4k3/8/8/3Pp3/8/8/8/4K3 w - e6 0 1", &board, NULL) == FEN_PARSE_OK,
+		"En passant square behind an enemy pawn that double pushed must be ok");
 }
@@ -0,0 +1,90 @@
+#include "../src/include/chess.h"
+#include "test.h"
+
+/* board_has_any_legal_move against the full generator */
+static usize check_any_legal(const TestWalkNode * node, void * data) {
+	(void)data;
+	MoveList list;
+	board_generate_moves(node->board, &list);
+	return board_has_any_legal_move(node->board) != (list.count != 0);
+}
+
+void test_game_status(void) {
+	const struct {
+		const char * fen;
+		ChessGameStatus status;
+	} cases[] = {
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", CHESS_GAME_ONGOING },
+		{ "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3", CHESS_GAME_CHECKMATE },
+		{ "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", CHESS_GAME_STALEMATE },
+		{ "k7/8/1QK5/8/8/8/8/8 b - - 0 1", CHESS_GAME_STALEMATE },
+		/* the en passant capture would expose the king, other moves remain */
+		{ "8/8/8/8/k2Pp2Q/8/8/3K4 b - d3 0 1", CHESS_GAME_ONGOING },
+		/* double check, the king has no square */
+		{ "k7/8/8/8/8/6n1/6PP/r6K w - - 0 1", CHESS_GAME_CHECKMATE },
+	};
+	for (u8 i = 0; i < SDL_arraysize(cases); ++i) {
+		ChessBoard board;
+		if (fen_parse_board(cases[i].fen, &board, NULL) != FEN_PARSE_OK) {
+			ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", cases[i].fen);
+			continue;
+		}
+		ChessGameStatus status = board_game_status(&board);
+		ASSERT(status == cases[i].status, "Game status of [%s] is %d, expected %d", cases[i].fen, status, cases[i].status);
+	}
+	const char * position = perft_positions[PERFT_KIWIPETE].fen;
+	ChessBoard board;
+	if (fen_parse_board(position, &board, NULL) != FEN_PARSE_OK) {
+		ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", position);
+	} else {
+		usize mismatches = test_walk(&board, 3, check_any_legal, NULL);
+		ASSERT(mismatches == 0, "board_has_any_legal_move disagreed with the generator %"SDL_PRIu64" times", mismatches);
+	}
+}
+
+/* every from, to pair against the generated move list */
+static usize check_is_legal(const TestWalkNode * node, void * data) {
+	(void)data;
+	ChessBoard * board = node->board;
+	usize mismatches = 0;
+	MoveList list;
+	board_generate_moves(board, &list);
+	LegalBoardMoves generated[64] = {0};
+	for (usize i = 0; i < list.count; ++i) {
+		generated[board_move_from(list.moves[i])] |= (BitBoard)1 << board_move_to(list.moves[i]);
+	}
+	for (u8 from = 0; from < 64; ++from) {
+		for (u8 to = 0; to < 64; ++to) {
+			bool expected = (generated[from] >> to) & 1;
+			if (board_is_legal_move(board, from, to, CHESS_QUEEN) != expected)
+				++mismatches;
+		}
+	}
+	return mismatches;
+}
+
+void test_is_legal_move(void) {
+	const char * positions[] = {
+		perft_positions[PERFT_KIWIPETE].fen,
+		perft_positions[PERFT_POSITION_4].fen,
+		perft_positions[PERFT_POSITION_3].fen,
+		"8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1",
+	};
+	for (u8 i = 0; i < SDL_arraysize(positions); ++i) {
+		ChessBoard board;
+		if (fen_parse_board(positions[i], &board, NULL) != FEN_PARSE_OK) {
+			ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", positions[i]);
+			continue;
+		}
+		usize mismatches = test_walk(&board, 2, check_is_legal, NULL);
+		ASSERT(mismatches == 0, "board_is_legal_move disagreed with the generator from [%s] %"SDL_PRIu64" times", positions[i], mismatches);
+	}
+	ChessBoard board;
+	if (fen_parse_board("4k3/1P6/8/8/8/8/8/4K3 w - - 0 1", &board, NULL) == FEN_PARSE_OK) {
+		ASSERT(!board_is_legal_move(&board, 54, 62, CHESS_KING), "Promoting to a king must be illegal");
+		ASSERT(!board_is_legal_move(&board, 54, 62, CHESS_PAWN), "Promoting to a pawn must be illegal");
+		ASSERT(board_is_legal_move(&board, 54, 62, CHESS_KNIGHT), "Promoting to a knight must be legal");
+	} else {
+		ASSERT_FAIL("FAILED TO PARSE PROMOTION TEST POSITION");
+	}
+}
@@ -0,0 +1,61 @@
+#include "../src/include/chess.h"
+#include "test.h"
+
+/* takes back the move leading here through the public API, the board must come back equal to its parent */
+static usize check_unmake(const TestWalkNode * node, void * data) {
+	(void)data;
+	if (!node->parent)
+		return 0;
+	ChessBoard board = *node->board;
+	board_unmake_move(&board, node->result, node->parent->half_moves);
+	return !chess_boards_equal(&board, node->parent, false) || board.hash != node->parent->hash;
+}
+
+void test_board_history(void) {
+	const char * position = perft_positions[PERFT_POSITION_4].fen;
+	ChessBoard board;
+	if (fen_parse_board(position, &board, NULL) != FEN_PARSE_OK) {
+		ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", position);
+	} else {
+		usize mismatches = test_walk(&board, 3, check_unmake, NULL);
+		ASSERT(mismatches == 0, "board_unmake_move failed to restore [%s] %"SDL_PRIu64" times", position, mismatches);
+	}
+
+	/* a long game picking moves by ply number, then taken back to the start */
+	board = INITIAL_CHESS_BOARD;
+	BoardHistory history;
+	board_history_init(&history, 0);
+	usize plies = 0;
+	for (; plies < 300; ++plies) {
+		LegalBoardMoves moves[64];
+		if (board_get_legal_moves(&board, moves) == 0)
+			break;
+		u8 from = 0;
+		for (usize skip = plies % 7;; from = (from + 1) % 64) {
+			if (moves[from] && skip-- == 0)
+				break;
+		}
+		u8 to = bitboard_pop_lsb(&moves[from]);
+		BoardMoveResult result;
+		OOM_CHECK(board_history_make_move(&history, &board, from, to, &result));
+		if (result.promotion)
+			board_set_promotion_type(&board, to, CHESS_QUEEN);
+	}
+	ASSERT(history.count == plies, "History holds %"SDL_PRIu64" of %"SDL_PRIu64" plies", history.count, plies);
+	while (board_history_undo(&history, &board)) {}
+	ASSERT(chess_boards_equal(&board, &INITIAL_CHESS_BOARD, true), "Undoing %"SDL_PRIu64" plies must give back the initial board", plies);
+	board_history_free(&history);
+
+	/* a limited history keeps the newest entries */
+	board_history_init(&history, 4);
+	for (u8 i = 0; i < 10; ++i) {
+		OOM_CHECK(board_history_push(&history, (BoardMoveResult){ .from = i }, i));
+	}
+	ASSERT(history.count == 4, "Limited history holds %"SDL_PRIu64" entries, expected 4", history.count);
+	ASSERT(board_history_get(&history, 0)->result.from == 6, "Oldest entry of a limited history is %u, expected 6",
+		board_history_get(&history, 0)->result.from);
+	BoardHistoryEntry entry;
+	ASSERT(board_history_pop(&history, &entry) && entry.result.from == 9 && entry.half_moves == 9,
+		"Popping a limited history must give the newest entry");
+	board_history_free(&history);
+}
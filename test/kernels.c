@@ -0,0 +1,40 @@
+#include "../src/include/chess.h"
+#include "../src/include/attack_map.h"
+#include "test.h"
+
+/* sums both attack maps over every position of a walk into data, in any move order since piece lists are unordered */
+static usize add_attack_maps(const TestWalkNode * node, void * data) {
+	*(u64 *)data += board_attack_map(node->board, WHITE_SIDE) * 31 + board_attack_map(node->board, BLACK_SIDE);
+	return 0;
+}
+
+static u64 attack_map_checksum(ChessBoard * board, usize depth) {
+	u64 sum = 0;
+	test_walk(board, depth, add_attack_maps, &sum);
+	return sum;
+}
+
+void test_kernels(void) {
+	const PerftPosition * kiwipete = &perft_positions[PERFT_KIWIPETE];
+	const char * position = kiwipete->fen;
+	ChessBoard board;
+	if (fen_parse_board(position, &board, NULL) != FEN_PARSE_OK) {
+		ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", position);
+		return;
+	}
+	ChessKernel selected = chess_get_kernel();
+	ChessKernel detected = chess_detect_kernel();
+	ASSERT(selected <= detected, "Selected kernel %s against detected %s", chess_kernel_str(selected), chess_kernel_str(detected));
+	ASSERT(!chess_set_kernel(detected + 1), "Setting a kernel above the detected %s", chess_kernel_str(detected));
+	ASSERT(chess_set_kernel(CHESS_KERNEL_SCALAR), "Setting the scalar kernel");
+	u64 expected_checksum = attack_map_checksum(&board, 2);
+	for (ChessKernel kernel = CHESS_KERNEL_SCALAR; kernel <= detected; ++kernel) {
+		chess_set_kernel(kernel);
+		usize count = board_count_moves(&board, kiwipete->depth);
+		ASSERT(count == kiwipete->count, "Move count under the %s kernel is %"SDL_PRIu64", expected %"SDL_PRIu64,
+			chess_kernel_str(kernel), count, kiwipete->count);
+		u64 checksum = attack_map_checksum(&board, 2);
+		ASSERT(checksum == expected_checksum, "Attack maps under the %s kernel differ from the scalar ones", chess_kernel_str(kernel));
+	}
+	chess_set_kernel(selected);
+}
@@ -0,0 +1,62 @@
+#include "../src/include/chess.h"
+#include "../src/include/attack_map.h"
+#include "../src/include/bench.h"
+#include <SDL3/SDL.h>
+
+#define ROUNDS 1000000
+
+static const char * positions[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+/* whole side attack maps ROUNDS times per position: 64 single square probes, the scalar fill and the vector fill */
+int main(void) {
+	chess_init();
+	u64 totals[3] = {0};
+	u64 sink = 0;
+	for (usize p = 0; p < SDL_arraysize(positions); ++p) {
+		ChessBoard board;
+		if (fen_parse_board(positions[p], &board, NULL) != FEN_PARSE_OK) {
+			SDL_Log("FAILED TO PARSE [%s]", positions[p]);
+			return 1;
+		}
+		BenchMarkStats bench;
+		u64 counters[3];
+		benchmark_begin(&bench);
+		for (usize r = 0; r < ROUNDS / 64; ++r) {
+			BitBoard map = 0;
+			for (u8 idx = 0; idx < 64; ++idx) {
+				if (board_square_attacked(&board, idx, r & 1))
+					map |= (BitBoard)1 << idx;
+			}
+			sink += map;
+		}
+		benchmark_end(&bench);
+		counters[0] = benchmark_elapsed_counter(&bench) * 64;
+		benchmark_begin(&bench);
+		for (usize r = 0; r < ROUNDS; ++r) {
+			sink += board_attack_map_scalar(&board, r & 1);
+		}
+		benchmark_end(&bench);
+		counters[1] = benchmark_elapsed_counter(&bench);
+		benchmark_begin(&bench);
+		for (usize r = 0; r < ROUNDS; ++r) {
+			sink += board_attack_map(&board, r & 1);
+		}
+		benchmark_end(&bench);
+		counters[2] = benchmark_elapsed_counter(&bench);
+		SDL_Log("[%s] square probes %"SDL_PRIu64", scalar fill %"SDL_PRIu64", vector fill %"SDL_PRIu64,
+			positions[p], counters[0], counters[1], counters[2]);
+		for (u8 i = 0; i < 3; ++i) {
+			totals[i] += counters[i];
+		}
+	}
+	SDL_Log("RESULTS (performance counter ticks for %d maps, sink %"SDL_PRIu64")", ROUNDS, sink);
+	SDL_Log("64 square probes took %"SDL_PRIu64" total", totals[0]);
+	SDL_Log("scalar fill took %"SDL_PRIu64" total", totals[1]);
+	SDL_Log("vector fill took %"SDL_PRIu64" total (%.2fx of scalar)", totals[2],
+		totals[2] ? (double)totals[1] / (double)totals[2] : 0.0);
+}
@@ -0,0 +1,105 @@
+#include "../src/include/chess.h"
+#include "../src/include/board_batch.h"
+#include "../src/include/bench.h"
+#include <SDL3/SDL.h>
+
+#define DEPTH 3
+#define ROUNDS 10
+
+static const char * positions[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+static ChessBoard * boards;
+static usize board_count;
+static usize board_capacity;
+
+static void collect(ChessBoard * board, usize depth) {
+	if (board_count == board_capacity) {
+		board_capacity = board_capacity ? board_capacity * 2 : 1024;
+		boards = SDL_realloc(boards, board_capacity * sizeof(*boards));
+	}
+	boards[board_count++] = *board;
+	if (depth == 0)
+		return;
+	MoveList list;
+	board_generate_moves(board, &list);
+	for (usize i = 0; i < list.count; ++i) {
+		ChessBoard next = *board;
+		board_make_move_packed(&next, list.moves[i]);
+		collect(&next, depth - 1);
+	}
+}
+
+static usize count_single(void) {
+	usize total = 0;
+	for (usize i = 0; i < board_count; ++i) {
+		total += board_count_moves(&boards[i], 1);
+	}
+	return total;
+}
+
+/* pushing the boards is part of the cost, datasets arrive as ChessBoards too */
+static usize count_batched(void) {
+	BoardBatch batch;
+	usize counts[BOARD_BATCH_SIZE];
+	usize total = 0;
+	board_batch_clear(&batch);
+	for (usize i = 0; i < board_count; ++i) {
+		board_batch_push(&batch, &boards[i]);
+		if (batch.count == BOARD_BATCH_SIZE || i + 1 == board_count) {
+			board_batch_count_moves(&batch, counts);
+			for (usize j = 0; j < batch.count; ++j) {
+				total += counts[j];
+			}
+			board_batch_clear(&batch);
+		}
+	}
+	return total;
+}
+
+/* legal move counts of every position DEPTH plies from the start positions, one board at a time and batched per kernel */
+int main(void) {
+	chess_init();
+	for (usize p = 0; p < SDL_arraysize(positions); ++p) {
+		ChessBoard board;
+		if (fen_parse_board(positions[p], &board, NULL) != FEN_PARSE_OK) {
+			SDL_Log("FAILED TO PARSE [%s]", positions[p]);
+			return 1;
+		}
+		collect(&board, DEPTH);
+	}
+	double frequency = (double)SDL_GetPerformanceFrequency();
+	BenchMarkStats bench;
+	usize expected = 0;
+	benchmark_begin(&bench);
+	for (usize r = 0; r < ROUNDS; ++r) {
+		expected = count_single();
+	}
+	benchmark_end(&bench);
+	double single_seconds = (double)benchmark_elapsed_counter(&bench) / frequency;
+	SDL_Log("RESULTS for %zu positions x %d rounds", board_count, ROUNDS);
+	SDL_Log("board_count_moves: %.2f Mpos/s", board_count * ROUNDS / single_seconds / 1e6);
+	ChessKernel selected = chess_get_kernel();
+	for (ChessKernel kernel = CHESS_KERNEL_SCALAR; kernel <= chess_detect_kernel(); ++kernel) {
+		chess_set_kernel(kernel);
+		usize total = 0;
+		benchmark_begin(&bench);
+		for (usize r = 0; r < ROUNDS; ++r) {
+			total = count_batched();
+		}
+		benchmark_end(&bench);
+		double seconds = (double)benchmark_elapsed_counter(&bench) / frequency;
+		if (total != expected) {
+			SDL_Log("COUNT MISMATCH under %s: batched %zu, single %zu", chess_kernel_str(kernel), total, expected);
+			return 1;
+		}
+		SDL_Log("batched %s: %.2f Mpos/s (%.2fx)", chess_kernel_str(kernel),
+			board_count * ROUNDS / seconds / 1e6, single_seconds / seconds);
+	}
+	chess_set_kernel(selected);
+	SDL_free(boards);
+}
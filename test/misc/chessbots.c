@@ -8,28 +8,15 @@ static void sigint(int _) {
 	intr = 1;
 }
 
-static LegalBoardMoves refresh_moves(ChessBoard * board, LegalBoardMoves moves[static 64]) {
-	LegalBoardMoves composite_moves = 0;
-	SDL_memset(moves, 0, sizeof(*moves) * 64);
-	for (u8 i = 0; i < 64; ++i) {
-		BoardSlot * slot = &board->slots[i];
-		if (slot->has_piece && slot->side == board->side) {
-			LegalBoardMoves _moves = board_get_legal_moves_for_piece(board, i);
-			moves[i] = _moves;
-			composite_moves |= _moves;
-		}
-	}
-	return composite_moves;
-}
-
 int main(void) {
 	ChessBoard board = INITIAL_CHESS_BOARD;
 	UciServer server;
 	UciClient client;
-	LegalBoardMoves moves[64];
 	UciMoveRequestData req;
+	BoardHistory history;
 	const char * args[] = { "stockfish", NULL };
-	refresh_moves(&board, moves);
+	chess_init();
+	board_history_init(&history, 0);
 	if (!uci_server_start(&server, args)) {
 		return 1;
 	}
@@ -55,16 +42,19 @@ int main(void) {
 		case UCI_POLL_CLIENT_CONTINUE:
 			break;
 		case UCI_POLL_CLIENT_MOVE_RESPONSE: {
-			LegalBoardMoves legal = moves[req.out_from];
-			SDL_assert(legal_board_moves_contains_idx(legal, req.out_to));
-			BoardMoveResult result = board_make_move(&board, req.out_from, req.out_to);
+			SDL_assert(board_is_legal_move(&board, req.out_from, req.out_to, req.out_promo));
+			BoardMoveResult result;
+			if (!board_history_make_move(&history, &board, req.out_from, req.out_to, &result)) {
+				SDL_Log("OOM");
+				goto finish;
+			}
 			SDL_assert(result.promotion == req.out_did_promo);
 			if (result.promotion) {
-				board.slots[req.out_to].piece = req.out_promo;
+				board_set_promotion_type(&board, req.out_to, req.out_promo);
 			}
-			LegalBoardMoves composite_moves = refresh_moves(&board, moves);
-			if (composite_moves == 0) {
-				SDL_Log("CHECKMATE or STALEMATE");
+			ChessGameStatus status = board_game_status(&board);
+			if (status != CHESS_GAME_ONGOING) {
+				SDL_Log(status == CHESS_GAME_CHECKMATE ? "CHECKMATE" : "STALEMATE");
 				goto finish;
 			}
 			uci_client_request_move(&client, &req);
@@ -73,6 +63,11 @@ int main(void) {
 		}
 	}
 finish:
+	/* replay the game backwards, it must end on the initial board */
+	SDL_Log("Taking back %zu plies", history.count);
+	while (board_history_undo(&history, &board)) {}
+	SDL_assert(board.hash == INITIAL_CHESS_BOARD.hash);
+	board_history_free(&history);
 	uci_client_free(&client);
 	uci_server_close(&server);
 }
@@ -0,0 +1,35 @@
+#include "../src/include/chess.h"
+#include "../src/include/perft.h"
+#include "../src/include/bench.h"
+#include <SDL3/SDL.h>
+
+#define PERFT_DEPTH 6
+#define SPLIT_DEPTH 2
+
+int main(void) {
+	chess_init();
+	int max_threads = SDL_GetNumLogicalCPUCores();
+	PerftThreadStats * stats = SDL_calloc(max_threads, sizeof(*stats));
+	if (!stats) {
+		SDL_Log("OOM");
+		return 1;
+	}
+	u64 single_thread_ticks = 0;
+	for (int threads = 1; threads <= max_threads; ++threads) {
+		ChessBoard board = INITIAL_CHESS_BOARD;
+		BenchMarkStats bench;
+		benchmark_begin(&bench);
+		usize count = board_count_moves_parallel(&board, PERFT_DEPTH, threads, SPLIT_DEPTH, stats, max_threads, NULL);
+		benchmark_end(&bench);
+		u64 ticks = bench.end_milliseconds - bench.begin_milliseconds;
+		if (threads == 1)
+			single_thread_ticks = ticks;
+		SDL_Log("%d threads: %zu nodes in %"SDL_PRIu64" ms (%.2fx)", threads, count, ticks,
+			ticks ? (double)single_thread_ticks / (double)ticks : 0.0);
+		for (int i = 0; i < threads; ++i) {
+			SDL_Log("    thread %d: %zu nodes, %zu tasks, %zu stolen",
+				i, stats[i].nodes, stats[i].tasks, stats[i].stolen);
+		}
+	}
+	SDL_free(stats);
+}
@@ -0,0 +1,74 @@
+#include "../src/include/chess.h"
+#include "../src/include/position.h"
+#include "../src/include/bench.h"
+#include <SDL3/SDL.h>
+
+#define ROUNDS 200000
+
+static const char * positions[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+/* applies every legal move of a position ROUNDS times with each approach */
+int main(void) {
+	chess_init();
+	SDL_Log("ChessBoard is %zu bytes, CompactPosition is %zu bytes", sizeof(ChessBoard), sizeof(CompactPosition));
+	u64 total_unmake = 0;
+	u64 total_board = 0;
+	u64 total_compact = 0;
+	u64 sink = 0;
+	for (usize p = 0; p < SDL_arraysize(positions); ++p) {
+		ChessBoard board;
+		if (fen_parse_board(positions[p], &board, NULL) != FEN_PARSE_OK) {
+			SDL_Log("FAILED TO PARSE [%s]", positions[p]);
+			return 1;
+		}
+		CompactPosition pos = position_from_board(&board);
+		MoveList list;
+		board_generate_moves(&board, &list);
+		BenchMarkStats bench;
+		benchmark_begin(&bench);
+		for (usize r = 0; r < ROUNDS; ++r) {
+			for (usize i = 0; i < list.count; ++i) {
+				usize half_moves = board.half_moves;
+				BoardMoveResult result = board_make_move_packed(&board, list.moves[i]);
+				sink += board.hash;
+				board_unmake_move(&board, result, half_moves);
+			}
+		}
+		benchmark_end(&bench);
+		u64 unmake_counter = benchmark_elapsed_counter(&bench);
+		benchmark_begin(&bench);
+		for (usize r = 0; r < ROUNDS; ++r) {
+			for (usize i = 0; i < list.count; ++i) {
+				ChessBoard next = board;
+				board_make_move_packed(&next, list.moves[i]);
+				sink += next.hash;
+			}
+		}
+		benchmark_end(&bench);
+		u64 board_counter = benchmark_elapsed_counter(&bench);
+		benchmark_begin(&bench);
+		for (usize r = 0; r < ROUNDS; ++r) {
+			for (usize i = 0; i < list.count; ++i) {
+				CompactPosition next = position_apply(&pos, list.moves[i]);
+				sink += next.squares[board_move_to(list.moves[i]) >> 1];
+			}
+		}
+		benchmark_end(&bench);
+		u64 compact_counter = benchmark_elapsed_counter(&bench);
+		SDL_Log("[%s] %zu moves: make/unmake %"SDL_PRIu64", ChessBoard copy-make %"SDL_PRIu64", CompactPosition copy-make %"SDL_PRIu64" (%.2fx of make/unmake)",
+			positions[p], list.count, unmake_counter, board_counter, compact_counter,
+			compact_counter ? (double)unmake_counter / (double)compact_counter : 0.0);
+		total_unmake += unmake_counter;
+		total_board += board_counter;
+		total_compact += compact_counter;
+	}
+	SDL_Log("RESULTS (performance counter ticks, sink %"SDL_PRIu64")", sink);
+	SDL_Log("make/unmake took %"SDL_PRIu64" total", total_unmake);
+	SDL_Log("ChessBoard copy-make took %"SDL_PRIu64" total", total_board);
+	SDL_Log("CompactPosition copy-make took %"SDL_PRIu64" total", total_compact);
+}
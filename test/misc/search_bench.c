@@ -0,0 +1,103 @@
+#include "../src/include/chess.h"
+#include "../src/include/bench.h"
+#include <SDL3/SDL.h>
+
+#define DEPTH 5
+#define MATE_SCORE 100000
+
+static const char * positions[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+static const i32 piece_values[CHESS_PIECE_COUNT] = { 100, 300, 300, 500, 900, 0 };
+
+static i32 evaluate(const ChessBoard * board) {
+	i32 score = 0;
+	for (ChessPiece piece = CHESS_PAWN; piece < CHESS_KING; ++piece) {
+		BitBoard pieces = board->bitboards.pieces[piece];
+		score += piece_values[piece] * (i32)bitboard_count(pieces & board->bitboards.sides[board->side]);
+		score -= piece_values[piece] * (i32)bitboard_count(pieces & board->bitboards.sides[!board->side]);
+	}
+	return score;
+}
+
+/* captures and promotions first so the material only evaluation gets its cutoffs */
+static void order_noisy_first(MoveList * list) {
+	usize noisy = 0;
+	for (usize i = 0; i < list->count; ++i) {
+		BoardMove move = list->moves[i];
+		if (board_move_is_capture(move) || board_move_is_promotion(move)) {
+			list->moves[i] = list->moves[noisy];
+			list->moves[noisy++] = move;
+		}
+	}
+}
+
+/* fail-hard negamax, pseudo picks which generator feeds it */
+static i32 alpha_beta(ChessBoard * board, usize depth, i32 alpha, i32 beta, bool pseudo, usize * nodes) {
+	++*nodes;
+	if (depth == 0)
+		return evaluate(board);
+	MoveList list;
+	if (pseudo)
+		board_generate_pseudo_moves(board, &list);
+	else
+		board_generate_moves(board, &list);
+	order_noisy_first(&list);
+	bool any_legal = false;
+	for (usize i = 0; i < list.count; ++i) {
+		if (pseudo && !board_move_is_legal(board, list.moves[i]))
+			continue;
+		any_legal = true;
+		usize half_moves = board->half_moves;
+		BoardMoveResult result = board_make_move_packed(board, list.moves[i]);
+		i32 score = -alpha_beta(board, depth - 1, -beta, -alpha, pseudo, nodes);
+		board_unmake_move(board, result, half_moves);
+		if (score >= beta)
+			return beta;
+		if (score > alpha)
+			alpha = score;
+	}
+	if (!any_legal)
+		return board_has_checks(board, board->side) ? -MATE_SCORE : 0;
+	return alpha;
+}
+
+/* searches every position to DEPTH with the legal and the pseudo-legal generator */
+int main(void) {
+	chess_init();
+	double frequency = (double)SDL_GetPerformanceFrequency();
+	double total_seconds[2] = {0};
+	usize total_nodes[2] = {0};
+	for (usize p = 0; p < SDL_arraysize(positions); ++p) {
+		ChessBoard board;
+		if (fen_parse_board(positions[p], &board, NULL) != FEN_PARSE_OK) {
+			SDL_Log("FAILED TO PARSE [%s]", positions[p]);
+			return 1;
+		}
+		i32 scores[2];
+		for (u8 pseudo = 0; pseudo < 2; ++pseudo) {
+			usize nodes = 0;
+			BenchMarkStats bench;
+			benchmark_begin(&bench);
+			scores[pseudo] = alpha_beta(&board, DEPTH, -MATE_SCORE - 1, MATE_SCORE + 1, pseudo, &nodes);
+			benchmark_end(&bench);
+			double seconds = (double)benchmark_elapsed_counter(&bench) / frequency;
+			total_seconds[pseudo] += seconds;
+			total_nodes[pseudo] += nodes;
+			SDL_Log("[%s] %s: score %d, %zu nodes in %.3fs, %.2f Mnps",
+				positions[p], pseudo ? "pseudo-legal" : "legal", scores[pseudo], nodes, seconds, nodes / seconds / 1e6);
+		}
+		if (scores[0] != scores[1]) {
+			SDL_Log("SCORE MISMATCH [%s]: legal %d, pseudo-legal %d", positions[p], scores[0], scores[1]);
+			return 1;
+		}
+	}
+	SDL_Log("RESULTS at depth %d", DEPTH);
+	SDL_Log("legal: %zu nodes, %.2f Mnps", total_nodes[0], total_nodes[0] / total_seconds[0] / 1e6);
+	SDL_Log("pseudo-legal: %zu nodes, %.2f Mnps (%.2fx)", total_nodes[1], total_nodes[1] / total_seconds[1] / 1e6,
+		(total_nodes[1] / total_seconds[1]) / (total_nodes[0] / total_seconds[0]));
+}
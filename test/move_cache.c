@@ -0,0 +1,72 @@
+#include "../src/include/chess.h"
+#include "../src/include/move_cache.h"
+#include "test.h"
+
+#define REPLAY_PLIES 200
+
+/* plays a fixed game, returns the number of plies until it ended or REPLAY_PLIES */
+static usize record_game(ChessBoard boards[static REPLAY_PLIES]) {
+	ChessBoard board = INITIAL_CHESS_BOARD;
+	usize plies = 0;
+	for (; plies < REPLAY_PLIES; ++plies) {
+		LegalBoardMoves moves[64];
+		if (board_get_legal_moves(&board, moves) == 0)
+			break;
+		boards[plies] = board;
+		u8 from = 0;
+		for (usize skip = plies % 5;; from = (from + 1) % 64) {
+			if (moves[from] && skip-- == 0)
+				break;
+		}
+		u8 to = bitboard_pop_lsb(&moves[from]);
+		if (board_make_move(&board, from, to).promotion)
+			board_set_promotion_type(&board, to, CHESS_QUEEN);
+	}
+	return plies;
+}
+
+/* replays every recorded position through the cache, counting tables that differ from a fresh generation */
+static usize replay_game(ChessBoard boards[static REPLAY_PLIES], usize plies, MoveCache * cache) {
+	usize mismatches = 0;
+	for (usize i = 0; i < plies; ++i) {
+		LegalBoardMoves expected[64];
+		LegalBoardMoves cached[64];
+		LegalBoardMoves expected_all = board_get_legal_moves(&boards[i], expected);
+		if (board_get_legal_moves_cached(&boards[i], cached, cache) != expected_all
+			|| SDL_memcmp(expected, cached, sizeof(expected)) != 0)
+			++mismatches;
+	}
+	return mismatches;
+}
+
+void test_move_cache(void) {
+	static ChessBoard boards[REPLAY_PLIES];
+	usize plies = record_game(boards);
+	MoveCache cache;
+	OOM_CHECK(move_cache_init(&cache, 1024));
+	usize mismatches = replay_game(boards, plies, &cache);
+	ASSERT(mismatches == 0, "First replay of %"SDL_PRIu64" plies gave %"SDL_PRIu64" wrong tables", plies, mismatches);
+	usize first_misses = cache.misses;
+	mismatches = replay_game(boards, plies, &cache);
+	ASSERT(mismatches == 0, "Cached replay of %"SDL_PRIu64" plies gave %"SDL_PRIu64" wrong tables", plies, mismatches);
+	ASSERT(cache.misses == first_misses && cache.hits + cache.misses == 2 * plies,
+		"Cached replay must only hit, got %"SDL_PRIu64" hits and %"SDL_PRIu64" misses", cache.hits, cache.misses);
+	move_cache_clear(&cache);
+	ASSERT(cache.hits == 0 && cache.misses == 0, "Clearing the cache must reset its statistics");
+	LegalBoardMoves moves[64];
+	ASSERT(!move_cache_probe(&cache, &boards[0], moves), "A cleared cache must miss the initial position");
+	move_cache_free(&cache);
+
+	/* a single bucket: the entry probed since it was stored gets a second chance over the others */
+	OOM_CHECK(move_cache_init(&cache, 1));
+	ASSERT(cache.mask == 0, "A 1KB cache must have a single bucket, found %"SDL_PRIu64, cache.mask + 1);
+	for (u8 i = 0; i < MOVE_CACHE_WAYS; ++i) {
+		board_get_legal_moves_cached(&boards[i], moves, &cache);
+	}
+	ASSERT(move_cache_probe(&cache, &boards[0], moves), "The first position must still be cached");
+	board_get_legal_moves_cached(&boards[MOVE_CACHE_WAYS], moves, &cache);
+	ASSERT(cache.evictions == 1, "Storing past the ways must evict once, evicted %"SDL_PRIu64, cache.evictions);
+	ASSERT(move_cache_probe(&cache, &boards[0], moves), "The referenced position must survive the eviction");
+	ASSERT(!move_cache_probe(&cache, &boards[1], moves), "The oldest unreferenced position must be evicted");
+	move_cache_free(&cache);
+}
@@ -0,0 +1,37 @@
+#include "../src/include/chess.h"
+#include "../src/include/position.h"
+#include "test.h"
+
+/* applies the move leading here to the parent's compact position and compares it with the made board */
+static usize compare_copy_make(const TestWalkNode * node, void * data) {
+	(void)data;
+	if (!node->parent)
+		return 0;
+	CompactPosition pos = position_from_board(node->parent);
+	CompactPosition expected = position_from_board(node->board);
+	CompactPosition applied = position_apply(&pos, node->move);
+	return SDL_memcmp(&expected, &applied, sizeof(expected)) != 0;
+}
+
+void test_compact_position(void) {
+	ASSERT(sizeof(CompactPosition) == 40, "Compact position is %u bytes", (unsigned)sizeof(CompactPosition));
+	const char * positions[] = {
+		perft_positions[PERFT_INITIAL].fen,
+		perft_positions[PERFT_KIWIPETE].fen,
+		perft_positions[PERFT_POSITION_4].fen,
+		"8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1",
+	};
+	for (u8 i = 0; i < SDL_arraysize(positions); ++i) {
+		ChessBoard board;
+		if (fen_parse_board(positions[i], &board, NULL) != FEN_PARSE_OK) {
+			ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", positions[i]);
+			continue;
+		}
+		CompactPosition pos = position_from_board(&board);
+		ChessBoard round_trip;
+		position_to_board(&pos, &round_trip);
+		ASSERT(chess_boards_equal(&round_trip, &board, true), "Compact position of [%s] must convert back losslessly", positions[i]);
+		usize mismatches = test_walk(&board, 3, compare_copy_make, NULL);
+		ASSERT(mismatches == 0, "Copy-make from [%s] differed from board_make_move_packed %"SDL_PRIu64" times", positions[i], mismatches);
+	}
+}
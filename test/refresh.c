@@ -0,0 +1,46 @@
+#include "../src/include/chess.h"
+#include "test.h"
+
+#define REFRESH_DEPTH 3
+
+typedef struct {
+	LegalBoardMoves moves[2][64];
+	BitBoard touched[2];
+} RefreshCache;
+
+/* refreshes the side to move like the GUI does, counting positions where it differs from a full generation.
+ * data holds a cache per ply, each node starts from the one its parent left.
+ */
+static usize check_refresh(const TestWalkNode * node, void * data) {
+	RefreshCache * cache = (RefreshCache *)data + node->ply;
+	ChessBoard * board = node->board;
+	if (node->parent) {
+		*cache = cache[-1];
+		BitBoard touched = board_move_touched_squares(board, node->result);
+		cache->touched[WHITE_SIDE] |= touched;
+		cache->touched[BLACK_SIDE] |= touched;
+	}
+	ChessSide side = board->side;
+	LegalBoardMoves expected[64];
+	LegalBoardMoves expected_all = board_get_legal_moves(board, expected);
+	LegalBoardMoves refreshed_all = board_refresh_legal_moves(board, cache->moves[side], cache->touched[side]);
+	usize mismatches = refreshed_all != expected_all || SDL_memcmp(expected, cache->moves[side], sizeof(expected)) != 0;
+	/* moves found in check cannot be patched later */
+	cache->touched[side] = board_has_checks(board, side) ? ~(BitBoard)0 : 0;
+	return mismatches;
+}
+
+void test_incremental_refresh(void) {
+	for (u8 i = 0; i < PERFT_POSITION_COUNT; ++i) {
+		const char * position = perft_positions[i].fen;
+		ChessBoard board;
+		if (fen_parse_board(position, &board, NULL) != FEN_PARSE_OK) {
+			ASSERT_FAIL("FAILED TO PARSE TEST POSITION [%s]", position);
+			continue;
+		}
+		/* nothing cached yet, both sides start from a full refresh */
+		RefreshCache caches[REFRESH_DEPTH + 1] = { { .touched = { ~(BitBoard)0, ~(BitBoard)0 } } };
+		usize mismatches = test_walk(&board, REFRESH_DEPTH, check_refresh, caches);
+		ASSERT(mismatches == 0, "Incremental refresh differed from full generation from [%s] %"SDL_PRIu64" times", position, mismatches);
+	}
+}
@@ -1,4 +1,5 @@
 #include "test.h"
+#include "../src/include/chess.h"
 
 static unsigned long passed = 0;
 static unsigned long failed = 0;
@@ -27,8 +28,62 @@ void test_report_assertion(bool condition, const char * file, const char * funct
 	SDL_CloseIO(stream);
 }
 
+const PerftPosition perft_positions[PERFT_POSITION_COUNT] = {
+	[PERFT_INITIAL] = { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4, 197281 },
+	[PERFT_KIWIPETE] = { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862 },
+	[PERFT_POSITION_3] = { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 4, 43238 },
+	[PERFT_POSITION_4] = { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3, 9467 },
+	[PERFT_POSITION_5] = { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379 },
+};
+
+static usize walk_node(TestWalkNode * node, usize depth, TestWalkVisit visit, void * data) {
+	usize mismatches = visit(node, data);
+	if (depth == 0)
+		return mismatches;
+	MoveList list;
+	board_generate_moves(node->board, &list);
+	for (usize i = 0; i < list.count; ++i) {
+		ChessBoard next = *node->board;
+		TestWalkNode child = {
+			.board = &next,
+			.parent = node->board,
+			.move = list.moves[i],
+			.result = board_make_move_packed(&next, list.moves[i]),
+			.ply = node->ply + 1,
+		};
+		mismatches += walk_node(&child, depth - 1, visit, data);
+	}
+	return mismatches;
+}
+
+usize test_walk(ChessBoard * board, usize depth, TestWalkVisit visit, void * data) {
+	TestWalkNode root = {
+		.board = board,
+		.parent = NULL,
+		.move = BOARD_MOVE_NONE,
+		.ply = 0,
+	};
+	return walk_node(&root, depth, visit, data);
+}
+
 int main(void) {
+	chess_init();
 	test_move_counts();
+	test_hashed_move_counts();
+	test_parallel_move_counts();
+	test_staged_move_counts();
+	test_pseudo_legal_move_counts();
+	test_zobrist_hash();
+	test_piece_lists();
+	test_compact_position();
+	test_board_history();
+	test_game_status();
+	test_is_legal_move();
+	test_incremental_refresh();
+	test_move_cache();
+	test_attack_map();
+	test_kernels();
+	test_board_batch();
 	test_fen_parse_and_encode();
 	SDL_Log("PASSED = %lu, FAILED = %lu", passed, failed);
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <SDL3/SDL.h>
+#include "../src/include/chess.h"
 
 #define LOG SDL_Log
 
@@ -10,5 +11,56 @@ void test_report_assertion(bool condition, const char * file, const char * funct
 #define ASSERT_OK(...) test_report_assertion(true, SDL_FILE, SDL_FUNCTION, SDL_LINE, __VA_ARGS__)
 #define OOM_CHECK(...) if (!(__VA_ARGS__)) { SDL_Log("OOM"); SDL_TriggerBreakpoint(); }
 
+/* the standard perft positions with their leaf count at depth */
+typedef struct {
+	const char * fen;
+	usize depth;
+	usize count;
+} PerftPosition;
+
+enum {
+	PERFT_INITIAL,
+	PERFT_KIWIPETE,
+	PERFT_POSITION_3,
+	PERFT_POSITION_4,
+	PERFT_POSITION_5,
+	PERFT_POSITION_COUNT
+};
+
+extern const PerftPosition perft_positions[PERFT_POSITION_COUNT];
+
+/* a position reached by test_walk, parent is NULL and move BOARD_MOVE_NONE at the root */
+typedef struct {
+	ChessBoard * board;
+	const ChessBoard * parent;
+	BoardMove move;
+	BoardMoveResult result; /* of move, made on a copy of parent */
+	usize ply;
+} TestWalkNode;
+
+/* checks one position of a walk, returns the number of mismatches found there */
+typedef usize (*TestWalkVisit)(const TestWalkNode * node, void * data);
+
+/* visits board and every position up to depth legal moves below it, parents before children, returns the summed mismatches */
+usize test_walk(ChessBoard * board, usize depth, TestWalkVisit visit, void * data);
+
+/* field by field comparison, reporting the first difference when report is set, in test/fen.c */
+bool chess_boards_equal(const ChessBoard * test, const ChessBoard * expected, bool report);
+
 void test_move_counts(void);
+void test_hashed_move_counts(void);
+void test_parallel_move_counts(void);
+void test_staged_move_counts(void);
+void test_pseudo_legal_move_counts(void);
+void test_zobrist_hash(void);
+void test_piece_lists(void);
+void test_compact_position(void);
+void test_board_history(void);
+void test_game_status(void);
+void test_is_legal_move(void);
+void test_incremental_refresh(void);
+void test_move_cache(void);
+void test_attack_map(void);
+void test_kernels(void);
+void test_board_batch(void);
 void test_fen_parse_and_encode(void);
@@ -0,0 +1,336 @@
+/* Writes src/include/chess_tables.h to stdout: the leaper, ray, slider and Zobrist tables chess.c looks up,
+ * as static const arrays so they sit in .rodata instead of being built by every process at startup.
+ * Run by the Makefile rule for that header, it only needs the SDL headers through chess.h, not the library.
+ */
+#include "../src/include/chess.h"
+#include <stdio.h>
+
+/* the four diagonal directions come first, then the four straight ones,
+ * each next to its opposite so ray ^ 1 reverses a direction
+ */
+static const Vec2i ray_directions[8] = {
+	{ 1, 1 }, { -1, -1 }, { 1, -1 }, { -1, 1 },
+	{ 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 },
+};
+
+#define DIAGONAL_RAYS 0
+#define STRAIGHT_RAYS 4
+
+#define BISHOP_ATTACK_TABLE_SIZE 5248
+#define ROOK_ATTACK_TABLE_SIZE 102400
+
+/* ray_table: every square from an index to the board edge in one direction, exclusive of the index
+ * ray_is_ascending: whether a direction walks toward higher indexes, picking the bit scan for its first blocker
+ */
+static BitBoard ray_table[8][64];
+static bool ray_is_ascending[8];
+
+static BitBoard knight_attack_table[64];
+static BitBoard king_attack_table[64];
+static BitBoard pawn_attack_table[2][64];
+static BitBoard between_table[64][64];
+static BitBoard line_table[64][64];
+static u8 relative_square[2][64];
+static u64 pawn_push_square[2][64]; /* u8 in chess.c, held as u64 for emit_table */
+
+static u64 zobrist_pieces[2][CHESS_PIECE_COUNT][64];
+static u64 zobrist_castle[2][2];
+static u64 zobrist_en_passant[8];
+static u64 zobrist_black_to_move;
+
+/* one square's slice of a shared attack table */
+typedef struct {
+	BitBoard mask;
+	BitBoard magic;
+	usize offset;
+	u8 shift;
+} SliderMagic;
+
+static SliderMagic bishop_magics[64];
+static SliderMagic rook_magics[64];
+static BitBoard bishop_attack_table[BISHOP_ATTACK_TABLE_SIZE];
+static BitBoard rook_attack_table[ROOK_ATTACK_TABLE_SIZE];
+static BitBoard bishop_pext_table[BISHOP_ATTACK_TABLE_SIZE];
+static BitBoard rook_pext_table[ROOK_ATTACK_TABLE_SIZE];
+
+static BitBoard idx_to_bitboard(u8 idx) {
+	return (BitBoard)1 << idx;
+}
+
+static bool pos_in_bounds(Vec2i pos) {
+	return pos.x >= 0 && pos.x < 8
+		&& pos.y >= 0 && pos.y < 8;
+}
+
+/* the nearest square of a non empty subset of a ray */
+static u8 ray_first_square(u8 ray, BitBoard squares) {
+	return ray_is_ascending[ray] ? (u8)__builtin_ctzll(squares) : (u8)(63 - __builtin_clzll(squares));
+}
+
+/* each ray cut behind its first occupied square (inclusive) */
+static BitBoard slider_attacks_slow(u8 idx, BitBoard occupied, u8 first_ray) {
+	BitBoard attacks = 0;
+	for (u8 ray = first_ray; ray < first_ray + 4; ++ray) {
+		BitBoard squares = ray_table[ray][idx];
+		BitBoard blockers = squares & occupied;
+		if (blockers) {
+			squares ^= ray_table[ray][ray_first_square(ray, blockers)];
+		}
+		attacks |= squares;
+	}
+	return attacks;
+}
+
+/* the attack set on an empty board, less the last square of each ray */
+static BitBoard slider_relevant_mask(u8 idx, u8 first_ray) {
+	BitBoard mask = 0;
+	for (u8 ray = first_ray; ray < first_ray + 4; ++ray) {
+		BitBoard squares = ray_table[ray][idx];
+		if (squares) {
+			/* the edge square is the one furthest along, the first seen walking backwards */
+			squares &= ~idx_to_bitboard(ray_first_square(ray ^ 1, squares));
+		}
+		mask |= squares;
+	}
+	return mask;
+}
+
+static u64 tables_rng_next(u64 * state) {
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/* Searches for a magic that maps every occupancy subset of the mask
+ * to a slot holding the right attack set (constructive collisions are fine).
+ * The carry-rippler walk meets the subsets in PEXT index order, so pext_table is filled along the way.
+ * Returns the number of table entries used.
+ */
+static usize find_slider_magic(SliderMagic * m, u8 idx, u8 first_ray, BitBoard * table, BitBoard * pext_table, u64 * rng) {
+	static BitBoard occupancies[4096];
+	static BitBoard attacks[4096];
+	static u32 epoch[4096];
+	for (usize i = 0; i < 4096; ++i) {
+		epoch[i] = 0;
+	}
+	m->mask = slider_relevant_mask(idx, first_ray);
+	u8 bits = bitboard_count(m->mask);
+	m->shift = 64 - bits;
+	usize size = (usize)1 << bits;
+	/* enumerate every subset of the mask with the carry-rippler trick */
+	BitBoard subset = 0;
+	for (usize i = 0; i < size; ++i) {
+		occupancies[i] = subset;
+		attacks[i] = slider_attacks_slow(idx, subset, first_ray);
+		pext_table[i] = attacks[i];
+		subset = (subset - m->mask) & m->mask;
+	}
+	for (u32 attempt = 1;; ++attempt) {
+		m->magic = tables_rng_next(rng) & tables_rng_next(rng) & tables_rng_next(rng);
+		if (bitboard_count((m->mask * m->magic) >> 56) < 6)
+			continue;
+		usize i;
+		for (i = 0; i < size; ++i) {
+			usize slot = (occupancies[i] * m->magic) >> m->shift;
+			if (epoch[slot] != attempt) {
+				epoch[slot] = attempt;
+				table[slot] = attacks[i];
+			} else if (table[slot] != attacks[i]) {
+				break;
+			}
+		}
+		if (i == size)
+			return size;
+	}
+}
+
+static BitBoard leaper_attacks_slow(u8 idx, const Vec2i * offsets, u8 count) {
+	BitBoard attacks = 0;
+	for (u8 i = 0; i < count; ++i) {
+		Vec2i pos = vec2i_add(vec2i_new(idx % 8, idx / 8), offsets[i]);
+		if (pos_in_bounds(pos)) {
+			attacks |= idx_to_bitboard(pos.y * 8 + pos.x);
+		}
+	}
+	return attacks;
+}
+
+static BitBoard ray_slow(u8 idx, Vec2i direction) {
+	BitBoard squares = 0;
+	Vec2i pos = vec2i_add(vec2i_new(idx % 8, idx / 8), direction);
+	while (pos_in_bounds(pos)) {
+		squares |= idx_to_bitboard(pos.y * 8 + pos.x);
+		pos = vec2i_add(pos, direction);
+	}
+	return squares;
+}
+
+static void init_line_tables(u8 a) {
+	for (u8 ray = 0; ray < 8; ++ray) {
+		BitBoard squares = ray_table[ray][a];
+		while (squares) {
+			u8 b = bitboard_pop_lsb(&squares);
+			line_table[a][b] = ray_table[ray][a] | ray_table[ray ^ 1][a] | idx_to_bitboard(a);
+			between_table[a][b] = ray_table[ray][a] & ray_table[ray ^ 1][b];
+		}
+	}
+}
+
+/* the raw key of INITIAL_CHESS_BOARD, folded into every key so the starting position hashes to 0 */
+static u64 initial_board_key(void) {
+	const ChessBoard * board = &INITIAL_CHESS_BOARD;
+	u64 hash = 0;
+	for (u8 side = 0; side < 2; ++side) {
+		if (board->sides[side].ks_castle_ok)
+			hash ^= zobrist_castle[side][0];
+		if (board->sides[side].qs_castle_ok)
+			hash ^= zobrist_castle[side][1];
+	}
+	if (board->opt_pawn != INVALID_PIECE_IDX)
+		hash ^= zobrist_en_passant[board->opt_pawn % 8];
+	for (u8 idx = 0; idx < 64; ++idx) {
+		const BoardSlot * slot = &board->slots[idx];
+		if (slot->has_piece)
+			hash ^= zobrist_pieces[slot->side][slot->piece][idx];
+	}
+	if (board->side == BLACK_SIDE)
+		hash ^= zobrist_black_to_move;
+	return hash;
+}
+
+/* the same random stream and order the startup table builders used, so magics and Zobrist keys keep their values.
+ * Returns false when the slider tables come out another size than the header promises.
+ */
+static bool build_tables(void) {
+	static const Vec2i pawn_offsets[2][2] = {
+		[WHITE_SIDE] = { { 1, 1 }, { -1, 1 } },
+		[BLACK_SIDE] = { { 1, -1 }, { -1, -1 } },
+	};
+	for (u8 ray = 0; ray < 8; ++ray) {
+		ray_is_ascending[ray] = ray_directions[ray].y > 0 || (ray_directions[ray].y == 0 && ray_directions[ray].x > 0);
+	}
+	for (u8 idx = 0; idx < 64; ++idx) {
+		knight_attack_table[idx] = leaper_attacks_slow(idx, knight_offsets, 8);
+		king_attack_table[idx] = leaper_attacks_slow(idx, king_offsets, 8);
+		pawn_attack_table[WHITE_SIDE][idx] = leaper_attacks_slow(idx, pawn_offsets[WHITE_SIDE], 2);
+		pawn_attack_table[BLACK_SIDE][idx] = leaper_attacks_slow(idx, pawn_offsets[BLACK_SIDE], 2);
+		for (u8 ray = 0; ray < 8; ++ray) {
+			ray_table[ray][idx] = ray_slow(idx, ray_directions[ray]);
+		}
+		relative_square[WHITE_SIDE][idx] = idx;
+		relative_square[BLACK_SIDE][idx] = 63 - idx;
+	}
+	for (u8 idx = 0; idx < 64; ++idx) {
+		init_line_tables(idx);
+		for (u8 side = 0; side < 2; ++side) {
+			/* one rank up in the side's own view, mapped back to a board index */
+			u8 rel = relative_square[side][idx];
+			pawn_push_square[side][idx] = rel < 56 ? relative_square[side][rel + 8] : INVALID_PIECE_IDX;
+		}
+	}
+	u64 rng = 0x9E3779B97F4A7C15ULL; /* fixed seed so the tables are reproducible */
+	usize bishop_offset = 0;
+	usize rook_offset = 0;
+	for (u8 idx = 0; idx < 64; ++idx) {
+		bishop_magics[idx].offset = bishop_offset;
+		bishop_offset += find_slider_magic(&bishop_magics[idx], idx, DIAGONAL_RAYS,
+			bishop_attack_table + bishop_offset, bishop_pext_table + bishop_offset, &rng);
+		rook_magics[idx].offset = rook_offset;
+		rook_offset += find_slider_magic(&rook_magics[idx], idx, STRAIGHT_RAYS,
+			rook_attack_table + rook_offset, rook_pext_table + rook_offset, &rng);
+	}
+	if (bishop_offset != BISHOP_ATTACK_TABLE_SIZE || rook_offset != ROOK_ATTACK_TABLE_SIZE) {
+		fprintf(stderr, "slider tables took %zu and %zu entries, expected %d and %d\n",
+			(size_t)bishop_offset, (size_t)rook_offset, BISHOP_ATTACK_TABLE_SIZE, ROOK_ATTACK_TABLE_SIZE);
+		return false;
+	}
+	for (u8 side = 0; side < 2; ++side) {
+		for (u8 piece = 0; piece < CHESS_PIECE_COUNT; ++piece) {
+			for (u8 idx = 0; idx < 64; ++idx) {
+				zobrist_pieces[side][piece][idx] = tables_rng_next(&rng);
+			}
+		}
+		zobrist_castle[side][0] = tables_rng_next(&rng);
+		zobrist_castle[side][1] = tables_rng_next(&rng);
+	}
+	for (u8 x = 0; x < 8; ++x) {
+		zobrist_en_passant[x] = tables_rng_next(&rng);
+	}
+	zobrist_black_to_move = tables_rng_next(&rng);
+	return true;
+}
+
+static void emit_line(u8 depth) {
+	printf("\n");
+	for (u8 i = 0; i < depth; ++i) {
+		printf("\t");
+	}
+}
+
+/* prints values as nested initializers following dims, hex ones four to a line */
+static const u64 * emit_values(const u64 * values, const usize * dims, u8 dim_count, bool hex, u8 depth) {
+	if (dim_count == 0) {
+		printf(hex ? "0x%016llXULL" : "%llu", (unsigned long long)*values);
+		return values + 1;
+	}
+	usize per_line = hex ? 4 : 16;
+	printf("{");
+	for (usize i = 0; i < dims[0]; ++i) {
+		if (dim_count > 1 || i % per_line == 0)
+			emit_line(depth + 1);
+		else
+			printf(" ");
+		values = emit_values(values, dims + 1, dim_count - 1, hex, depth + 1);
+		printf(",");
+	}
+	emit_line(depth);
+	printf("}");
+	return values;
+}
+
+static void emit_table(const char * declaration, const u64 * values, const usize * dims, u8 dim_count, bool hex) {
+	printf("static const %s = ", declaration);
+	emit_values(values, dims, dim_count, hex, 0);
+	printf(";\n\n");
+}
+
+static void emit_magics(const char * name, const SliderMagic * magics) {
+	printf("static const SliderMagic %s[64] = {\n", name);
+	for (u8 idx = 0; idx < 64; ++idx) {
+		printf("\t{ .mask = 0x%016llXULL, .magic = 0x%016llXULL, .offset = %zu, .shift = %u },\n",
+			(unsigned long long)magics[idx].mask, (unsigned long long)magics[idx].magic,
+			(size_t)magics[idx].offset, magics[idx].shift);
+	}
+	printf("};\n\n");
+}
+
+int main(void) {
+	if (!build_tables())
+		return 1;
+	printf("/* Generated by tools/gen_tables.c, do not edit. Included by chess.c only, after SliderMagic. */\n\n");
+	emit_table("BitBoard knight_attack_table[64]", knight_attack_table, (usize[]){ 64 }, 1, true);
+	emit_table("BitBoard king_attack_table[64]", king_attack_table, (usize[]){ 64 }, 1, true);
+	emit_table("BitBoard pawn_attack_table[2][64]", &pawn_attack_table[0][0], (usize[]){ 2, 64 }, 2, true);
+	emit_table("BitBoard between_table[64][64]", &between_table[0][0], (usize[]){ 64, 64 }, 2, true);
+	emit_table("BitBoard line_table[64][64]", &line_table[0][0], (usize[]){ 64, 64 }, 2, true);
+	emit_table("u8 pawn_push_square[2][64]", &pawn_push_square[0][0], (usize[]){ 2, 64 }, 2, false);
+	emit_table("u64 zobrist_pieces[2][CHESS_PIECE_COUNT][64]", &zobrist_pieces[0][0][0],
+		(usize[]){ 2, CHESS_PIECE_COUNT, 64 }, 3, true);
+	emit_table("u64 zobrist_castle[2][2]", &zobrist_castle[0][0], (usize[]){ 2, 2 }, 2, true);
+	emit_table("u64 zobrist_en_passant[8]", zobrist_en_passant, (usize[]){ 8 }, 1, true);
+	printf("static const u64 zobrist_black_to_move = 0x%016llXULL;\n", (unsigned long long)zobrist_black_to_move);
+	printf("static const u64 zobrist_initial = 0x%016llXULL;\n\n", (unsigned long long)initial_board_key());
+	printf("#ifndef CHESS_MAILBOX\n");
+	printf("#define BISHOP_ATTACK_TABLE_SIZE %d\n", BISHOP_ATTACK_TABLE_SIZE);
+	printf("#define ROOK_ATTACK_TABLE_SIZE %d\n\n", ROOK_ATTACK_TABLE_SIZE);
+	emit_magics("bishop_magics", bishop_magics);
+	emit_magics("rook_magics", rook_magics);
+	emit_table("BitBoard bishop_attack_table[BISHOP_ATTACK_TABLE_SIZE]", bishop_attack_table, (usize[]){ BISHOP_ATTACK_TABLE_SIZE }, 1, true);
+	emit_table("BitBoard rook_attack_table[ROOK_ATTACK_TABLE_SIZE]", rook_attack_table, (usize[]){ ROOK_ATTACK_TABLE_SIZE }, 1, true);
+	printf("#ifdef CHESS_X86_KERNELS\n");
+	emit_table("BitBoard bishop_pext_table[BISHOP_ATTACK_TABLE_SIZE]", bishop_pext_table, (usize[]){ BISHOP_ATTACK_TABLE_SIZE }, 1, true);
+	emit_table("BitBoard rook_pext_table[ROOK_ATTACK_TABLE_SIZE]", rook_pext_table, (usize[]){ ROOK_ATTACK_TABLE_SIZE }, 1, true);
+	printf("#endif\n#endif\n");
+	return 0;
+}